@@ -104,6 +104,9 @@ struct WAV_t
 sounditem_t::sounditem_t(const char *n)
   : cacheitem_t(n)
 {
+  lumpnum = -1;
+  rate = depth = length = 0;
+  data = sdata = NULL;
 }
 
 sounditem_t::~sounditem_t()
@@ -112,10 +115,18 @@ sounditem_t::~sounditem_t()
     Z_Free(data);
 }
 
+unsigned sounditem_t::Size()
+{
+  return data ? Z_GetSize(data) : 0;
+}
+
 
 
 class soundcache_t : public cache_t<sounditem_t>
 {
+public:
+  soundcache_t() : cache_t<sounditem_t>("sounds") {}
+
 protected:
   // We assume that the sound is in Doom or WAV sound format.
   virtual sounditem_t *Load(const char *p)
@@ -72,33 +72,33 @@ struct ai_target_t
 };
 
 // temp variables
-static ai_target_t cMissile; // closest dangerous missile (must be avoided)
+static thread_local ai_target_t cMissile; // closest dangerous missile (must be avoided)
 
-static ai_target_t cEnemy;       // closest directly visible enemy
-static ai_target_t cUnseenEnemy; // closest nonvisible enemy (node-reachable)
+static thread_local ai_target_t cEnemy;       // closest directly visible enemy
+static thread_local ai_target_t cUnseenEnemy; // closest nonvisible enemy (node-reachable)
 
-static ai_target_t fTeammate;       // furthest directly reachable teammate
-static ai_target_t cUnseenTeammate; // closest not directly reachable teammate (node-reachable)
+static thread_local ai_target_t fTeammate;       // furthest directly reachable teammate
+static thread_local ai_target_t cUnseenTeammate; // closest not directly reachable teammate (node-reachable)
 
-static ai_target_t bItem; // best directly reachable AND visible item
-static float  bItemWeight;
-static ai_target_t bUnseenItem; // best non-visible item (node-reachable)
-static float  bUnseenItemWeight;
+static thread_local ai_target_t bItem; // best directly reachable AND visible item
+static thread_local float  bItemWeight;
+static thread_local ai_target_t bUnseenItem; // best non-visible item (node-reachable)
+static thread_local float  bUnseenItemWeight;
 
-static float bWeaponValue; // value of the best currently usable weapon
-static bool  HaveWeaponFor[NUMAMMO]; // does the bot have a weapon for the given ammotype?
+static thread_local float bWeaponValue; // value of the best currently usable weapon
+static thread_local bool  HaveWeaponFor[NUMAMMO]; // does the bot have a weapon for the given ammotype?
 
-static fixed_t JumpHeight; // How high can the bots jump?
+static thread_local fixed_t JumpHeight; // How high can the bots jump?
 
 //=================================================================
 //     Simple straight-line reachability checks
 //=================================================================
-static Actor	*bot, *goal;
-static sector_t *last_sector;
-static fixed_t   last_floorz;
+static thread_local Actor	*bot, *goal;
+static thread_local sector_t *last_sector;
+static thread_local fixed_t   last_floorz;
 
 /// returns true if the intercepting object can be bypassed
-static bool PTR_QuickReachable(intercept_t *in)
+static bool PTR_QuickReachable(spatialquery_t &q, intercept_t *in)
 {
   if (in->isaline)
     {
@@ -159,7 +159,8 @@ bool ACBot::QuickReachable(Actor *g)
 	  return false;
       }
 
-  return mp->blockmap->PathTraverse(pawn->pos, goal->pos, PT_ADDLINES|PT_ADDTHINGS, PTR_QuickReachable);
+  query_scope_t q(mp);
+  return mp->blockmap->PathTraverse(*q, pawn->pos, goal->pos, PT_ADDLINES|PT_ADDTHINGS, PTR_QuickReachable);
 }
 
 
@@ -173,7 +174,8 @@ bool ACBot::QuickReachable(fixed_t x, fixed_t y)
   last_floorz = pawn->Feet(); // 3d floors...
   vec_t<fixed_t> r(x, y, 0);
 
-  return mp->blockmap->PathTraverse(pawn->pos, r, PT_ADDLINES|PT_ADDTHINGS, PTR_QuickReachable);
+  query_scope_t q(mp);
+  return mp->blockmap->PathTraverse(*q, pawn->pos, r, PT_ADDLINES|PT_ADDTHINGS, PTR_QuickReachable);
 }
 
 
@@ -401,9 +403,16 @@ void ACBot::LookForThings()
   bUnseenItem.dist = fixed_t::FMAX;
   bUnseenItemWeight = 0.0;
 
-  // search through the list of all thinkers
+  // search through the list of all thinkers, dormant monsters are still there to be fought
+  ScanThinkers(mp->thinkercap);
+  ScanThinkers(mp->dormantcap);
+}
+
 
-  for (Thinker *th = mp->thinkercap.Next(); th != &mp->thinkercap; th = th->Next())
+/// Looks for enemies, teammates, items and missiles in a ring of Thinkers.
+void ACBot::ScanThinkers(Thinker &cap)
+{
+  for (Thinker *th = cap.Next(); th != &cap; th = th->Next())
     {
       Actor *actor = th->Inherits<Actor>();
       if (!actor)
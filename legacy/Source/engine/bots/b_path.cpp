@@ -181,16 +181,16 @@ SearchNode_t *priorityQ_t::RemoveNode(SearchNode_t *node)
 //   BotNodes class
 //====================================================
 
-static fixed_t botteledestx, botteledesty;
-static bool botteledestfound = false;
-static fixed_t pawn_height;
-static sector_t *last_sector;
+static thread_local fixed_t botteledestx, botteledesty;
+static thread_local bool botteledestfound = false;
+static thread_local fixed_t pawn_height;
+static thread_local sector_t *last_sector;
 
 /// Examines the trace intercept, sees it if can be activated/opened/circumvented.
 /// Sets the teledest / door variables above accordingly.
-static bool PTR_BotPath(intercept_t *in)
+static bool PTR_BotPath(spatialquery_t &q, intercept_t *in)
 {
-  static sector_t *oksector = NULL; // latest reached sector
+  static thread_local sector_t *oksector = NULL; // latest reached sector
 
   if (in->isaline)
     {
@@ -291,7 +291,7 @@ static bool PTR_BotPath(intercept_t *in)
 }
 
 
-bool PIT_BBoxFit(line_t *ld);
+bool PIT_BBoxFit(spatialquery_t &q, line_t *ld);
 
 
 /// Checks if the given destination is reachable from the given starting location (by mo!).
@@ -302,6 +302,7 @@ bool BotNodes::DirectlyReachable(Actor *mo, fixed_t x, fixed_t y, fixed_t destx,
 
   vec_t<fixed_t> start(x,y,0);
   vec_t<fixed_t> dest(destx, desty, 0);
+  query_scope_t q(mp);
 
   botteledestfound = false;
 
@@ -325,7 +326,7 @@ bool BotNodes::DirectlyReachable(Actor *mo, fixed_t x, fixed_t y, fixed_t destx,
 	      && mp->PathTraverse(x - 1, y - 1, destx, desty, PT_ADDLINES|PT_ADDTHINGS, PTR_BotPath)
 	      && mp->PathTraverse(x + 1, y - 1, destx, desty, PT_ADDLINES|PT_ADDTHINGS, PTR_BotPath)
 	      */
-	      && mp->blockmap->PathTraverse(start, dest, PT_ADDLINES|PT_ADDTHINGS, PTR_BotPath))
+	      && mp->blockmap->PathTraverse(*q, start, dest, PT_ADDLINES|PT_ADDTHINGS, PTR_BotPath))
 	    return true; // FIXME why do many traces with nearly identical endpoints??
 	  else
 	    {
@@ -336,7 +337,7 @@ bool BotNodes::DirectlyReachable(Actor *mo, fixed_t x, fixed_t y, fixed_t destx,
       else
 	{
 	  pawn_height = 56;
-	  return mp->blockmap->PathTraverse(start, dest, PT_ADDLINES, PTR_BotPath);
+	  return mp->blockmap->PathTraverse(*q, start, dest, PT_ADDLINES, PTR_BotPath);
 	}
     }
 
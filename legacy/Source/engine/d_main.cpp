@@ -51,13 +51,18 @@
 #include "s_sound.h"
 
 #include "w_wad.h"
+#include "m_profile.h"
 #include "z_zone.h"
+#include "z_cache.h"
 
 
 void GenerateTables();
 void SV_Init();
 void CL_Init();
 void PrepareGameData();
+void SetGameDataSnapshot(const char *filename);
+void SetRejectCache(const char *filename);
+void SetBlockmapCache(const char *filename);
 
 // Marty
 static void Help(void);  
@@ -125,6 +130,10 @@ static gamemission_t mission = gmi_doom2;
 
 // the file where all game vars and settings are saved
 #define CONFIGFILENAME   "config.cfg"  
+#define DIGESTFILENAME   "digests.txt"
+#define SNAPSHOTFILENAME "gamedata.bin"
+#define REJECTFILENAME   "rejects.bin"
+#define BLOCKMAPFILENAME "blockmaps.bin"
 
 bool devparm    = false; // started game with -devparm
 bool singletics = false; // timedemo
@@ -240,6 +249,8 @@ void D_DoomLoop()
         continue;
       }
 
+      PROFILE_ZONE("D_DoomLoop"); // one frame
+
 #ifdef HW3SOUND
       HW3S_BeginFrameUpdate();
 #endif
@@ -258,6 +269,7 @@ void D_DoomLoop()
           
           S.UpdateSounds();         // move positional sounds, adjust volumes                   
           game.Display();           // Update display, next frame, with current state.
+          cachebase_t::Maintain();  // enforce cache budgets between frames
         }
         else if (rendertimeout < now)
         {
@@ -505,6 +517,13 @@ static void D_CheckWadVersion()
 
 
 
+/// Prints the timing of the initialization stages run by D_DoomMain.
+void Command_StartupInfo_f()
+{
+  startuptimes_t::PrintReport();
+}
+
+
 // set up correct paths to wads, configfiles and saves
 void D_SetPaths()
 {
@@ -570,6 +589,15 @@ void D_SetPaths()
 		if (DirectoryCheck_isPath(MyHomy) == 0)        
 				mkdir(MyHomy);        
                               
+		// md5 digests of the resource files, see FileCache::UpdateDigests
+		fc.SetDigestCache((legacyhome + "\\" DIGESTFILENAME).c_str());
+		// parsed DECORATE classes, see PrepareGameData
+		SetGameDataSnapshot((legacyhome + "\\" SNAPSHOTFILENAME).c_str());
+		// REJECT tables built for maps without one, see Map::LoadReject
+		SetRejectCache((legacyhome + "\\" REJECTFILENAME).c_str());
+		// blockmaps generated for maps without a usable one, see blockmap_t::blockmap_t(Map *)
+		SetBlockmapCache((legacyhome + "\\" BLOCKMAPFILENAME).c_str());
+
 		sprintf(savegamename, "%s\\Saves\\%s", legacyhome.c_str(), "savegame_%d.sav");
 		sprintf(hubsavename , "%s\\Saves\\%s", legacyhome.c_str(), "hubsave_%02d.sav");
 }
@@ -672,50 +700,86 @@ bool D_DoomMain()
 
   //========================== start subsystem initializations ==========================
 
+  // Each stage is timed for the -startuptimes report.
+  startuptimes_t::Start();
+
   // memory management
-  Z_Init(); 
+  {
+    stagetimer_t s("zone");
+    Z_Init();
+  }
 
   // file cache
-  if (!fc.InitMultipleFiles(startupwadfiles))
-    I_Error("A WAD file was not found\n");
+  {
+    stagetimer_t s("resource files");
+    if (!fc.InitMultipleFiles(startupwadfiles))
+      I_Error("A WAD file was not found\n");
 
-  // file cache Debug List View
-  fc.CacheListIndex();
+    // file cache Debug List View
+    fc.CacheListIndex();
   
-  // see that legacy.wad version matches program version
-  if (!M_CheckParm("-noversioncheck"))
-    D_CheckWadVersion();
+    // see that legacy.wad version matches program version
+    if (!M_CheckParm("-noversioncheck"))
+      D_CheckWadVersion();
+  }
 
   // command buffer
-  COM.Init();
+  {
+    stagetimer_t s("command buffer");
+    COM.Init();
+  }
 
   // system-specific stuff
-  I_SysInit();
+  {
+    stagetimer_t s("system");
+    I_SysInit();
+  }
 
   // generate a couple of lookup tables
-  GenerateTables();
+  {
+    stagetimer_t s("lookup tables");
+    GenerateTables();
+  }
 
   // Server init
-  SV_Init();
+  {
+    stagetimer_t s("server");
+    SV_Init();
+  }
 
   // Client init
   if (!game.dedicated) 
-    CL_Init();
+    {
+      stagetimer_t s("client");
+      CL_Init();
+    }
 
   // Convert old static game data structures into dynamic ones.
   // DEHACKED patches etc. must be applied before this.
-  PrepareGameData();
+  {
+    stagetimer_t s("game data");
+    PrepareGameData();
+  }
 
   // all consvars are now registered
   //------------------------------------- CONFIG.CFG
   // loads and executes config file
-  M_FirstLoadConfig(); // WARNING : this does a "COM_BufExecute()"
+  {
+    stagetimer_t s("config");
+    M_FirstLoadConfig(); // WARNING : this does a "COM_BufExecute()"
+  }
 
   if (!game.dedicated)
     {
       // set user default mode or mode set at cmdline
+      stagetimer_t s("video mode");
       vid.CheckDefaultMode();
     }
+
+  startuptimes_t::Stop();
+
+  if (devparm || M_CheckParm("-startuptimes"))
+    startuptimes_t::PrintReport();
  
   // ------------- starting the game ----------------
 
@@ -769,6 +833,13 @@ bool D_DoomMain()
   p = M_CheckParm("-loadgame");
   if (p && M_IsNextParm())
     COM.AppendText(va("load %d\n", atoi(myargv[p+1])));
+  else if ((p = M_CheckParm("-benchsim")) && p+2 < myargc)
+    {
+      // headless simulation benchmark, quits when done
+      const char *bots = (p+3 < myargc && myargv[p+3][0] != '-') ? myargv[p+3] : "0";
+      const char *out = (M_CheckParm("-benchout") && M_IsNextParm()) ? M_GetNextParm() : "benchsim.json";
+      COM.AppendText(va("benchsim %s %s %s \"%s\"\nquit\n", myargv[p+1], myargv[p+2], bots, out));
+    }
   else if (autostart)
     BeginGame(episode, sk, public_server);
   else
@@ -846,6 +917,11 @@ static void Help(void)
       " -maxdemo num    Limit record demo size, in KiB\n"
       " -devparm        Develop mode\n"
       " -nodraw         Timedemo without draw\n"
+      " -threads num    Number of worker threads\n"
+      " -startuptimes   Print the startup timing report\n"
+      " -nosnapshot     Always parse DECORATE, ignore the snapshot\n"
+      " -benchsim map tics [bots]  Time the simulation of a map and quit\n"
+      " -benchout file  JSON output file of -benchsim\n"
       "\n"
       " -h Games/G      Displays all available and supported games.\n"
       " -h WadList/WL   Displays all available iwads that are being\n"
@@ -120,6 +120,8 @@ IMPLEMENT_CLASS(Actor, Thinker);
 
 Actor::~Actor()
 {
+  ClearReferrers();
+
   if (pres)
     delete pres; // delete the presentation object too
 }
@@ -341,6 +343,14 @@ void Actor::ClientThink()
 //              Rest of Actor implementation
 //===========================================================
 
+// NULLs all the references to this Actor.
+void Actor::ClearReferrers()
+{
+  while (referrers.first)
+    referrers.first->Unlink();
+}
+
+
 // NULLs pointers to objects that will be deleted soon
 void Actor::CheckPointers()
 {
@@ -1372,8 +1382,8 @@ void DActor::Think()
 bool DActor::SetState(statenum_t ns, bool call)
 {
   //remember states seen, to detect cycles:    
-  static statenum_t seenstate_tab[NUMSTATES]; // fast transition table
-  static int recursion;                       // detects recursion
+  static thread_local statenum_t seenstate_tab[NUMSTATES]; // fast transition table
+  static thread_local int recursion;                       // detects recursion
 
   statenum_t *seenstate = seenstate_tab;      // pointer to table
 
@@ -1426,6 +1436,9 @@ bool DActor::SetState(statenum_t ns, bool call)
 // Returns true if the mobj is still present.
 bool DActor::SetState(const state_t *ns, bool call)
 {
+  if (eflags & MFE_DORMANT)
+    mp->WakeActor(this); // activated from outside
+
   do {
     if (!ns || ns == &states[S_NULL])
       {
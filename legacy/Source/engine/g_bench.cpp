@@ -0,0 +1,262 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Headless simulation benchmark.
+///
+/// "benchsim <map> <tics> [bots] [file]" loads a map without any human players,
+/// optionally adds some bots, and runs Map::Ticker back to back as fast as it goes,
+/// with no rendering, input or network in between. The time spent in each phase of
+/// Map::Ticker is recorded for every tic, and reported as percentiles.
+
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "doomdef.h"
+#include "command.h"
+#include "cvars.h"
+
+#include "g_bench.h"
+#include "g_game.h"
+#include "g_map.h"
+#include "g_mapinfo.h"
+#include "g_player.h"
+
+#include "acbot.h"
+#include "b_path.h"
+
+#include "m_misc.h"
+#include "m_random.h"
+#include "m_threads.h"
+
+
+const char *simbench_t::phasenames[NUM_PHASES] =
+{
+  "RunThinkers",
+  "RespawnPlayers",
+  "UpdateSpecials",
+  "RespawnSpecials",
+  "UpdateSoundSequences",
+  "FS_DelayedScripts",
+  "HandlePlayers",
+  "PointerCleanup",
+  "Total"
+};
+
+simbench_t *simbench_t::active = NULL;
+
+
+void simbench_t::Begin()
+{
+  for (int i=0; i<NUM_PHASES; i++)
+    current[i] = 0;
+
+  tic_start = last = clock::now();
+}
+
+
+// Adds the time since the previous mark to phase p.
+void simbench_t::AddTime(phase_e p)
+{
+  clock::time_point now = clock::now();
+  current[p] += chrono::duration<double, milli>(now - last).count();
+  last = now;
+}
+
+
+void simbench_t::End()
+{
+  current[Total] = chrono::duration<double, milli>(clock::now() - tic_start).count();
+
+  for (int i=0; i<NUM_PHASES; i++)
+    times[i].push_back(current[i]);
+}
+
+
+/// Nearest-rank percentile of a sorted vector.
+static float Percentile(const vector<float> &v, float p)
+{
+  int n = v.size();
+  int k = int(p * n / 100 + 0.5f) - 1;
+  return v[max(0, min(k, n-1))];
+}
+
+
+void simbench_t::Report(const char *mapname, int bots, double load_ms, double run_ms, const char *fname)
+{
+  int tics = times[Total].size();
+  if (!tics)
+    return;
+
+  FILE *f = NULL;
+  if (fname)
+    {
+      f = fopen(fname, "wb");
+      if (!f)
+	CONS_Printf("Could not open '%s' for writing.\n", fname);
+    }
+
+  CONS_Printf("%s: %d tics, %d bots, %d threads\n", mapname, tics, bots, workers.NumThreads());
+  CONS_Printf("load %.1f ms, run %.1f ms, %.1f tics/s\n", load_ms, run_ms, tics * 1000.0 / run_ms);
+  CONS_Printf("%-20s %8s %8s %8s %8s %8s\n", "phase (ms)", "mean", "p50", "p90", "p99", "max");
+
+  if (f)
+    {
+      fprintf(f, "{\n  \"map\": \"%s\",\n  \"tics\": %d,\n  \"bots\": %d,\n  \"threads\": %d,\n",
+	      mapname, tics, bots, workers.NumThreads());
+      fprintf(f, "  \"load_ms\": %.3f,\n  \"run_ms\": %.3f,\n  \"phases\": {\n", load_ms, run_ms);
+    }
+
+  for (int i=0; i<NUM_PHASES; i++)
+    {
+      vector<float> &v = times[i];
+      sort(v.begin(), v.end());
+
+      double sum = 0;
+      for (int k=0; k<tics; k++)
+	sum += v[k];
+
+      float p50 = Percentile(v, 50), p90 = Percentile(v, 90), p99 = Percentile(v, 99);
+      CONS_Printf("%-20s %8.3f %8.3f %8.3f %8.3f %8.3f\n", phasenames[i], sum / tics, p50, p90, p99, v[tics-1]);
+
+      if (f)
+	fprintf(f, "    \"%s\": {\"total\": %.3f, \"mean\": %.4f, \"min\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+		phasenames[i], sum, sum / tics, v[0], p50, p90, p99, v[tics-1], i < NUM_PHASES-1 ? "," : "");
+    }
+
+  if (f)
+    {
+      fprintf(f, "  }\n}\n");
+      fclose(f);
+      CONS_Printf("Results written to %s\n", fname);
+    }
+}
+
+
+
+/// Runs a map headless for a number of tics, timing the phases of Map::Ticker.
+void Command_BenchSim_f()
+{
+  if (COM.Argc() < 3 || COM.Argc() > 5)
+    {
+      CONS_Printf("Usage: benchsim <map> <tics> [bots] [file]: time the simulation of a map without rendering.\n");
+      return;
+    }
+
+  if (game.Playing())
+    {
+      CONS_Printf("First end the current game.\n");
+      return;
+    }
+
+  int tics = atoi(COM.Argv(2));
+  if (tics <= 0)
+    {
+      CONS_Printf("The number of tics must be positive.\n");
+      return;
+    }
+
+  int bots = COM.Argc() >= 4 ? atoi(COM.Argv(3)) : 0;
+  bots = max(0, min(bots, int(NUM_LOCALBOTS)));
+  const char *fname = COM.Argc() >= 5 ? COM.Argv(4) : "benchsim.json";
+
+  if (!game.SV_SpawnServer(false))
+    return;
+
+  MapInfo *m = game.FindMapInfo(string_to_upper(COM.Argv(1)).c_str());
+  if (!m || !m->found)
+    {
+      CONS_Printf("Map %s cannot be found.\n", COM.Argv(1));
+      game.SV_Reset(false);
+      return;
+    }
+
+  CONS_Printf("Benchmarking %s (%s), %d tics, %d bots...\n", m->nicename.c_str(), m->lumpname.c_str(), tics, bots);
+
+  M_ClearRandom(); // the same random sequences every time
+  int old_deathmatch = cv_deathmatch.value;
+  if (bots > 0)
+    cv_deathmatch.Set(1); // more spawn spots, and the bots have something to do
+  game.currentcluster = game.FindCluster(m->cluster);
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  if (!m->Activate(NULL))
+    {
+      CONS_Printf("Map %s could not be loaded.\n", m->lumpname.c_str());
+      game.SV_Reset(false);
+      game.currentcluster = NULL;
+      cv_deathmatch.Set(old_deathmatch);
+      return;
+    }
+
+  Map *mp = m->me;
+  if (bots > 0 && !mp->botnodes)
+    mp->botnodes = new BotNodes(mp);
+
+  int i;
+  for (i=0; i<bots; i++)
+    {
+      LocalPlayerInfo *lp = &LocalPlayers[NUM_LOCALHUMANS + i];
+      PlayerInfo *p = new PlayerInfo(lp);
+      lp->info = game.AddPlayer(p);
+      if (!lp->info)
+	{
+	  CONS_Printf("Cannot add any more players.\n");
+	  delete p;
+	  break;
+	}
+      lp->ai = new ACBot(game.skill);
+      mp->AddPlayer(p);
+    }
+  bots = i;
+
+  chrono::steady_clock::time_point loaded = chrono::steady_clock::now();
+
+  simbench_t bench;
+  simbench_t::active = &bench;
+
+  for (int t=0; t<tics; t++)
+    {
+      for (i=0; i<bots; i++)
+	LocalPlayers[NUM_LOCALHUMANS + i].GetInput(1);
+
+      game.tic++;
+      mp->Ticker();
+    }
+
+  simbench_t::active = NULL;
+  chrono::steady_clock::time_point done = chrono::steady_clock::now();
+
+  bench.Report(m->lumpname.c_str(), bots,
+	       chrono::duration<double, milli>(loaded - start).count(),
+	       chrono::duration<double, milli>(done - loaded).count(), fname);
+
+  // clean up
+  for (i=0; i<bots; i++)
+    {
+      LocalPlayerInfo *lp = &LocalPlayers[NUM_LOCALHUMANS + i];
+      delete lp->ai;
+      lp->ai = NULL;
+    }
+
+  game.SV_Reset(false); // removes the bots
+  m->Close(-1);
+  game.currentcluster = NULL;
+  cv_deathmatch.Set(old_deathmatch);
+}
@@ -28,9 +28,11 @@
 #include "g_map.h"
 #include "g_decorate.h"
 #include "info.h"
+#include "m_argv.h"
 #include "p_setup.h"
 #include "mnemonics.h" // flags are shared with BEX
 #include "sounds.h"
+#include "m_profile.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -46,6 +48,9 @@ vector<const char *> spritenames;
 
 bool Read_DECORATE(int lump);
 
+static int decorate_errors = 0; ///< number of DECORATE errors reported so far
+static string snapshotfile;     ///< DECORATE snapshot file, empty means none
+
 // Label names for standard state sequences
 static const char *StandardLabels[] = {"spawn", "see", "melee", "missile", "pain", "death", "xdeath", "crash", "raise"};
 
@@ -486,6 +491,7 @@ void ActorInfo::Error(const char *format, ...)
 {
   va_list p;
 
+  decorate_errors++;
   va_start(p, format);
   fprintf(stderr, "DECORATE: ");
   fprintf(stderr, format, p);
@@ -642,42 +648,19 @@ static void HexenPatchEngine()
 }
 
 
-/// Convert static game data structures into dynamic ones. DECORATE scripts are processed after the conversion.
-void PrepareGameData()
+/// Sets the file used for storing the DECORATE snapshot.
+void SetGameDataSnapshot(const char *filename)
 {
-  switch (game.mode)
-    {
-    case gm_hexen:
-      HexenPatchEngine();
-      break;
-    case gm_heretic:
-      HereticPatchEngine();
-      break;
-    default:
-      DoomPatchEngine();
-    }
+  snapshotfile = filename;
+}
+
 
+/// Converts the mobjinfo table into DECORATE classes.
+static void ConvertMobjInfo()
+{
   int i;
   ActorInfo *ai;
 
-  // prepare spritename mapping
-  spritenames.resize(NUMSPRITES);
-  for (i=0; i<NUMSPRITES; i++)
-    spritenames[i] = orig_sprnames[i];
-
-  if (devparm)
-    {
-      printf("Named DECORATE classes:\n");
-      for (i=0; i<NUMMOBJTYPES; i++)
-	{
-	  if (mobjinfo[i].classname)
-	    printf(" %s\n", mobjinfo[i].classname);
-	}
-    }
-
-  // convert mobjinfo table to DECORATE class dictionary
-  // TODO: after this mobjinfo should not be used at all! fix
-
   for (i = MT_LEGACY; i <= MT_LEGACY_S_END; i++)
     {
       ai = new ActorInfo(mobjinfo[i], gm_none);
@@ -708,8 +691,15 @@ void PrepareGameData()
       aid.Insert(ai);
       aid.InsertDoomEd(ai, game.mode == gm_hexen);
     }
+}
 
 
+/// Adds the classes implemented in the engine. Their DoomEd numbers are not used by mobjinfo.
+static void AddNativeClasses()
+{
+  int i;
+  ActorInfo *ai;
+
   static ActorInfo *NativeAIs[3] =
   {
     new SkyboxCameraAI("SkyViewpoint", 9080),
@@ -723,16 +713,76 @@ void PrepareGameData()
       aid.Insert(ai);
       aid.InsertDoomEd(ai, true);
     }
+}
+
+
+/// Convert static game data structures into dynamic ones. DECORATE scripts are processed after the conversion.
+/// If the resource files have not changed, both are replaced by loading the snapshot.
+void PrepareGameData()
+{
+  switch (game.mode)
+    {
+    case gm_hexen:
+      HexenPatchEngine();
+      break;
+    case gm_heretic:
+      HereticPatchEngine();
+      break;
+    default:
+      DoomPatchEngine();
+    }
+
+  int i;
+
+  // prepare spritename mapping
+  spritenames.resize(NUMSPRITES);
+  for (i=0; i<NUMSPRITES; i++)
+    spritenames[i] = orig_sprnames[i];
+
+  if (devparm)
+    {
+      printf("Named DECORATE classes:\n");
+      for (i=0; i<NUMMOBJTYPES; i++)
+	{
+	  if (mobjinfo[i].classname)
+	    printf(" %s\n", mobjinfo[i].classname);
+	}
+    }
+
+  // The native classes come first, the snapshot refers to them by name.
+  AddNativeClasses();
 
   CONS_Printf("Reading DECORATE definitions...\n");
+  stagetimer_t s("DECORATE");
+
+  // The class dictionary only depends on the resource files, so we can reuse it if those have not changed.
+  // The snapshot also holds the classes converted from mobjinfo.
+  byte key[16];
+  bool snapshot = !snapshotfile.empty() && !M_CheckParm("-nosnapshot") && fc.GetIdentityKey(key);
 
-  int n = fc.Size();
-  for (int i = 0; i < n; i++)
+  if (snapshot && aid.LoadSnapshot(snapshotfile.c_str(), key))
+    {
+      CONS_Printf(" Using the snapshot %s.\n", snapshotfile.c_str());
+    }
+  else
     {
-      // cumulative reading
-      int lump = -1;
-      while ((lump = fc.FindNumForNameFile("DECORATE", i, lump+1)) >= 0)
-	Read_DECORATE(lump);
+      // convert mobjinfo table to DECORATE class dictionary
+      // TODO: after this mobjinfo should not be used at all! fix
+      ConvertMobjInfo();
+
+      int errors = decorate_errors;
+      int n = fc.Size();
+      for (int i = 0; i < n; i++)
+	{
+	  // cumulative reading
+	  int lump = -1;
+	  while ((lump = fc.FindNumForNameFile("DECORATE", i, lump+1)) >= 0)
+	    Read_DECORATE(lump);
+	}
+
+      // keep showing the errors until they are fixed
+      if (snapshot && decorate_errors == errors && !aid.SaveSnapshot(snapshotfile.c_str(), key))
+	CONS_Printf(" Could not write the snapshot %s.\n", snapshotfile.c_str());
     }
 
   CONS_Printf(" %d Actor types defined.\n", aid.Size());
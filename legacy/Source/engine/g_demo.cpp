@@ -62,6 +62,14 @@ bool         singledemo;             // quit after playing a demo from cmdline
 bool         precache = true;        // if true, load all graphics at start
 
 
+// True if the simulation must be exactly reproducible, which rules out
+// the optional features that change the order of events (netgames and demos).
+bool GameInfo::StrictSync()
+{
+  return netgame || demorecording || demoplayback || state == GS_DEMOPLAYBACK;
+}
+
+
 //added:03-02-98:
 //
 // was G_Downgrade
@@ -31,6 +31,10 @@
 #include "g_map.h"
 #include "dstrings.h"
 #include "sounds.h"
+#include "command.h"
+#include "cvars.h"
+#include "m_random.h"
+#include "m_threads.h"
 
 #include "z_zone.h"
 
@@ -57,16 +61,46 @@ MapCluster::MapCluster(int n)
 }
 
 
+static biglock_t maplock; ///< serializes the thinkers of Maps ticked in parallel
+
 // ticks the entire cluster forward in time
 void MapCluster::Ticker()
 {
   int i, n = maps.size();
-  
+
+  if (!cv_parallelmaps.value || !game.server || game.StrictSync() || n < 2)
+    {
+      for (i=0; i<n; i++)
+	maps[i]->Ticker();
+      return;
+    }
+
+  // The thinkers of each active Map are run in a job of their own, holding maplock except
+  // inside parallel sections (see Map::CheckSight). Each Map uses its own P_Random sequence,
+  // saved with the Map (see Map::Serialize), and keeps its other game state in the Map.
+  // Still, the zone and Thinker pool allocations, sounds and console messages follow the order
+  // in which the jobs get the lock, and all the Maps run their Thinkers before the rest
+  // of their tic. Since the result is not exactly reproducible, netgames and demos never do this.
+  // NOTE: This relies on WorkerPool::Wait running only the jobs of its own group, since a Map job
+  // waiting for its own parallel work inside the lock must not pick up the job of another Map.
+  vector<Map *> active;
+  for (i=0; i<n; i++)
+    if (maps[i]->me && maps[i]->state != MapInfo::MAP_INSTASIS)
+      active.push_back(maps[i]->me);
+
+  workers.ParallelFor(active.size(), [&active](int k)
+    {
+      Map *m = active[k];
+      maplock.Lock();
+      byte *old = P_SetRandSource(&m->rndindex);
+      m->RunThinkers();
+      P_SetRandSource(old);
+      maplock.Unlock();
+    });
+
+  // the rest of the tic, in the usual order
   for (i=0; i<n; i++)
-  {
-      maps[i]->Ticker();
-  }
-  //CONS_Printf("[%s][%d]MapCluster::Ticker\n",__FILE__,__LINE__); 
+    maps[i]->Ticker(false);
 }
 
 
@@ -71,6 +71,8 @@ Map::Map(MapInfo *i)
   info = i;
   lumpname = i->lumpname;
   hexen_format = false;
+  rndindex = 0;
+  region = new memregion_t;
 
   vertexes = NULL;
   lines = NULL;
@@ -86,6 +88,10 @@ Map::Map(MapInfo *i)
 
   blockmap = NULL;
   rejectmatrix = NULL;
+  sector_moves = 0;
+  ResetSight();
+  for (int i=0; i<sight_numstats; i++)
+    sightstats[i] = 0;
 
   fadetable = NULL;
   skytexture = NULL;
@@ -102,6 +108,7 @@ Map::Map(MapInfo *i)
   ActiveAmbientSeq = NULL;
 
   braintargeton = 0;
+  braineasy = false;
 
   effects = NULL;
   botnodes = NULL;
@@ -113,34 +120,8 @@ Map::~Map()
 {
   if (vertexes) // geometry loaded
     {
-      Z_Free(vertexes);
-      Z_Free(lines);
-      Z_Free(sides);
-      Z_Free(sectors);
-      Z_Free(subsectors);
-      Z_Free(nodes);
-      Z_Free(segs);
-      if (polyobjs)
-	{
-	  for (int i=0; i < NumPolyobjs; i++)
-	    {
-	      if (polyobjs[i].segs)
-		Z_Free(polyobjs[i].segs);
-
-	      if (polyobjs[i].base_points)
-		Z_Free(polyobjs[i].base_points);
-
-	      if (polyobjs[i].current_points)
-		Z_Free(polyobjs[i].current_points);
-	    }
-
-	  Z_Free(polyobjs);
-	}
-      Z_Free(linebuffer);
-
-      // Remove GL nodes if they exist.
-      if (glvertexes)
-	Z_Free(glvertexes);
+      // The geometry arrays live in the memory region, which is released below.
+      // Cached lumps may already have been cached with a different tag, so they are freed normally.
       if (glvis)
 	Z_Free(glvis);
 
@@ -151,8 +132,6 @@ Map::~Map()
 
       if (ACS_base)
 	Z_Free(ACS_base);
-
-      Z_Free(mapthings);
     }
 
   if (effects)
@@ -168,6 +147,12 @@ Map::~Map()
       delete t;
     }
 
+  for (t = dormantcap.next; t != &dormantcap; t = next)
+    {
+      next = t->next;
+      delete t;
+    }
+
   int n = DeletionList.size();
   for (int i=0; i<n; i++)
     delete DeletionList[i];
@@ -178,6 +163,9 @@ Map::~Map()
   R_ClearLevelSplats(); // FIXME find a better way
   // 3D sounds must be stopped when their sources are deleted...
   S.Stop3DSounds(); // TODO not correct, since several maps may run simultaneously.
+
+  // and finally all the map data goes in one go
+  delete region;
 }
 
 
@@ -719,6 +707,8 @@ int Map::Massacre()
 {
   int count = 0;
 
+  WakeAll(); // dormant ones too
+
   for (Thinker *th = thinkercap.next; th != &thinkercap; th = th->next)
     {
       Actor *a = th->Inherits<Actor>();
@@ -813,24 +803,28 @@ void Map::BossDeath(const DActor *mo)
 
   const state_t *finalst = P_FinalState(mo->info->deathstate);
 
-  // scan the remaining thinkers to see
+  // scan the remaining thinkers (dormant ones too) to see
   // if all bosses are dead
-  for (Thinker *th = thinkercap.next ; th != &thinkercap ; th=th->next)
+  for (int r = 0; r < 2; r++)
     {
-      DActor *a = th->Inherits<DActor>();
-      if (!a)
-	continue;
-
-      if (a != mo && a->type == mo->type
-	  // && a->health > 0           // the old one (doom original 1.9)
-	  // && !(a->flags & MF_CORPSE) // the Heretic one
-	  && a->state != finalst)
-	// this is better because a thing becomes MF_CORPSE while still falling down.
-	// We want to see the deaths completely.
-        {
-	  // other boss not dead
-	  return;
-        }
+      Thinker &cap = r ? dormantcap : thinkercap;
+      for (Thinker *th = cap.next ; th != &cap ; th=th->next)
+	{
+	  DActor *a = th->Inherits<DActor>();
+	  if (!a)
+	    continue;
+
+	  if (a != mo && a->type == mo->type
+	      // && a->health > 0           // the old one (doom original 1.9)
+	      // && !(a->flags & MF_CORPSE) // the Heretic one
+	      && a->state != finalst)
+	    // this is better because a thing becomes MF_CORPSE while still falling down.
+	    // We want to see the deaths completely.
+	    {
+	      // other boss not dead
+	      return;
+	    }
+	}
     }
 
   // victory!
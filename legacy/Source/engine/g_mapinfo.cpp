@@ -93,12 +93,12 @@ MapInfo::~MapInfo()
 
 
 /// ticks the map forward
-void MapInfo::Ticker()
+void MapInfo::Ticker(bool runthinkers)
 {
   //CONS_Printf("[%s][%d]MapInfo::Ticker\n",__FILE__,__LINE__);
   if (me && state != MAP_INSTASIS)
     {
-      me->Ticker();
+      me->Ticker(runthinkers);
 
       // check fraglimit cvar TODO how does this work? when are the scores (or teamscores) zeroed?
       if (game.server && cv_fraglimit.value && game.CheckScoreLimit())
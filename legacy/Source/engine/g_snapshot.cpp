@@ -0,0 +1,522 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Binary snapshots of the ActorInfo dictionary.
+///
+/// A snapshot stores the DECORATE class dictionary exactly as it stands after all the
+/// DECORATE lumps have been parsed. All pointers are stored as indices: states either into
+/// the static states[] table or into the snapshot's own state pool, action functions into
+/// BEX_DActorMnemonics and touch functions into mobjinfo. Loading it is a single read
+/// followed by a pass of pointer fixups.
+
+#include <stddef.h>
+#include <map>
+#include <vector>
+#include "doomdef.h"
+#include "g_game.h"
+#include "g_decorate.h"
+#include "info.h"
+#include "mnemonics.h"
+
+using namespace std;
+
+
+#define SNAPSHOT_MAGIC   "LEGSNAP"
+#define SNAPSHOT_VERSION 2
+
+/// Snapshot file header. The file is in host byte order, foreign files are simply stale.
+struct snap_header_t
+{
+  char   magic[8];
+  Sint32 version, legacy_version, byteorder;
+  Sint32 numstates, nummobjtypes, numsprites, nummnemonics; ///< sizes of the static tables the snapshot refers to
+  Sint32 gamemode, dedicated; ///< affect the class dictionary and the sound numbers
+  byte   key[16];             ///< identity of the resource files, see FileCache::GetIdentityKey
+  Sint32 num_classes, num_labels, num_states, num_doomed, strings_size;
+};
+
+struct snap_class_t
+{
+  Sint32 name, obituary, hitobituary, modelname, skinname; ///< offsets into the string table
+  Sint32 mobjtype, game, spawn_always, doomednum, spawnhealth, reactiontime;
+  Sint32 radius, height; ///< raw fixed_t values
+  float  mass, speed;
+  Uint32 flags, flags2, damage;
+  Sint32 painchance;
+  Sint32 sounds[5];
+  Sint32 states[9];      ///< spawnstate...raisestate
+  Sint32 touchf;         ///< mobjinfo entry with the same touch function, or -1
+  Sint32 first_label, num_labels;
+};
+
+struct snap_label_t
+{
+  char   label[SL_LEN], jumplabel[SL_LEN];
+  Sint32 num_states, jumplabelnum, jumpoffset;
+  Sint32 dyn_states;
+  Sint32 states;         ///< label_states
+};
+
+struct snap_state_t
+{
+  Sint32 sprite, frame, tics;
+  Sint32 action;         ///< BEX_DActorMnemonics entry, or -1
+  Sint32 nextstate;
+};
+
+struct snap_doomed_t
+{
+  Sint32 doomednum, classnum;
+};
+
+
+/// State pointers are stored as -1 (NULL), states[] indices, or NUMSTATES + state pool index.
+struct state_encoder_t
+{
+  struct run_t
+  {
+    int first, num;
+  };
+  map<const state_t*, run_t> runs; ///< dynamically allocated state arrays, by address
+  bool ok;
+
+  state_encoder_t() : ok(true) {}
+
+  int Encode(const state_t *p)
+  {
+    if (!p)
+      return -1;
+
+    if (p >= states && p < states + NUMSTATES)
+      return p - states;
+
+    map<const state_t*, run_t>::iterator i = runs.upper_bound(p);
+    if (i != runs.begin())
+      {
+	--i;
+	int ofs = p - i->first;
+	if (ofs < i->second.num)
+	  return NUMSTATES + i->second.first + ofs;
+      }
+
+    ok = false; // points to something we do not know about
+    return -1;
+  }
+};
+
+
+static int NumMnemonics()
+{
+  int n = 0;
+  while (BEX_DActorMnemonics[n].name)
+    n++;
+  return n;
+}
+
+
+static void SetHeader(snap_header_t &h, const byte *key)
+{
+  memset(&h, 0, sizeof(h));
+  strcpy(h.magic, SNAPSHOT_MAGIC);
+  h.version = SNAPSHOT_VERSION;
+  h.legacy_version = LEGACY_VERSION;
+  h.byteorder = 0x01020304;
+  h.numstates = NUMSTATES;
+  h.nummobjtypes = NUMMOBJTYPES;
+  h.numsprites = NUMSPRITES;
+  h.nummnemonics = NumMnemonics();
+  h.gamemode = game.mode;
+  h.dedicated = game.dedicated;
+  memcpy(h.key, key, 16);
+}
+
+
+static int AddString(vector<char> &strings, const string &s)
+{
+  int ofs = strings.size();
+  strings.insert(strings.end(), s.c_str(), s.c_str() + s.size() + 1);
+  return ofs;
+}
+
+
+bool ActorInfoDictionary::SaveSnapshot(const char *filename, const byte *key)
+{
+  vector<ActorInfo*> classes;
+  map<const ActorInfo*, int> classnum;
+  for (dict_iter_t i = dict_map.begin(); i != dict_map.end(); i++)
+    {
+      classnum[i->second] = classes.size();
+      classes.push_back(i->second);
+    }
+
+  // lay out the state pool
+  state_encoder_t enc;
+  int num_states = 0, num_labels = 0;
+  for (unsigned c = 0; c < classes.size(); c++)
+    {
+      vector<ActorInfo::statelabel_t> &labels = classes[c]->labels;
+      for (unsigned j = 0; j < labels.size(); j++)
+	if (labels[j].dyn_states && labels[j].label_states)
+	  {
+	    state_encoder_t::run_t r = {num_states, labels[j].num_states};
+	    enc.runs[labels[j].label_states] = r;
+	    num_states += labels[j].num_states;
+	  }
+      num_labels += labels.size();
+    }
+
+  map<actionf_p1, int> actions;
+  for (int i = NumMnemonics() - 1; i >= 0; i--)
+    actions[BEX_DActorMnemonics[i].ptr] = i; // first one wins
+
+  vector<snap_class_t> sc(classes.size());
+  vector<snap_label_t> sl;
+  vector<snap_state_t> ss;
+  vector<char> strings;
+  sl.reserve(num_labels);
+  ss.reserve(num_states);
+
+  for (unsigned c = 0; c < classes.size(); c++)
+    {
+      ActorInfo *a = classes[c];
+      snap_class_t &s = sc[c];
+
+      s.name         = AddString(strings, a->classname);
+      s.obituary     = AddString(strings, a->obituary);
+      s.hitobituary  = AddString(strings, a->hitobituary);
+      s.modelname    = AddString(strings, a->modelname);
+      s.skinname     = AddString(strings, a->skinname);
+      s.mobjtype     = a->mobjtype;
+      s.game         = a->game;
+      s.spawn_always = a->spawn_always;
+      s.doomednum    = a->doomednum;
+      s.spawnhealth  = a->spawnhealth;
+      s.reactiontime = a->reactiontime;
+      s.radius       = a->radius.value();
+      s.height       = a->height.value();
+      s.mass         = a->mass;
+      s.speed        = a->speed;
+      s.flags        = a->flags;
+      s.flags2       = a->flags2;
+      s.damage       = a->damage;
+      s.painchance   = a->painchance;
+      for (int k = 0; k < 5; k++)
+	s.sounds[k] = (&a->seesound)[k]; // HACK, like the state pointers below
+      for (int k = 0; k < 9; k++)
+	s.states[k] = enc.Encode((&a->spawnstate)[k]);
+
+      s.touchf = -1;
+      if (a->touchf)
+	{
+	  for (int k = 0; k < NUMMOBJTYPES && s.touchf < 0; k++)
+	    if (mobjinfo[k].touchf == a->touchf)
+	      s.touchf = k;
+	  if (s.touchf < 0)
+	    return false;
+	}
+
+      vector<ActorInfo::statelabel_t> &labels = a->labels;
+      s.first_label = sl.size();
+      s.num_labels = labels.size();
+
+      for (unsigned j = 0; j < labels.size(); j++)
+	{
+	  ActorInfo::statelabel_t &l = labels[j];
+	  snap_label_t t;
+	  memset(&t, 0, sizeof(t));
+	  memcpy(t.label, l.label, SL_LEN);
+	  memcpy(t.jumplabel, l.jumplabel, SL_LEN);
+	  t.num_states   = l.num_states;
+	  t.jumplabelnum = l.jumplabelnum;
+	  t.jumpoffset   = l.jumpoffset;
+	  t.dyn_states   = l.dyn_states;
+	  t.states       = enc.Encode(l.label_states);
+	  sl.push_back(t);
+
+	  if (!l.dyn_states || !l.label_states)
+	    continue;
+
+	  // runs were laid out in this same order
+	  for (int k = 0; k < l.num_states; k++)
+	    {
+	      const state_t &st = l.label_states[k];
+	      snap_state_t u;
+	      u.sprite = st.sprite;
+	      u.frame  = st.frame;
+	      u.tics   = st.tics;
+	      u.action = -1;
+	      if (st.action)
+		{
+		  map<actionf_p1, int>::iterator m = actions.find(st.action);
+		  if (m == actions.end())
+		    return false;
+		  u.action = m->second;
+		}
+	      u.nextstate = enc.Encode(st.nextstate);
+	      ss.push_back(u);
+	    }
+	}
+    }
+
+  vector<snap_doomed_t> sd;
+  for (doomed_iter_t i = doomed_map.begin(); i != doomed_map.end(); i++)
+    {
+      map<const ActorInfo*, int>::iterator j = classnum.find(i->second);
+      if (j == classnum.end())
+	return false;
+      snap_doomed_t d = {i->first, j->second};
+      sd.push_back(d);
+    }
+
+  if (!enc.ok)
+    return false;
+
+  snap_header_t h;
+  SetHeader(h, key);
+  h.num_classes  = sc.size();
+  h.num_labels   = sl.size();
+  h.num_states   = ss.size();
+  h.num_doomed   = sd.size();
+  h.strings_size = strings.size();
+
+  FILE *f = fopen(filename, "wb");
+  if (!f)
+    return false;
+
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  ok = ok && (sc.empty() || fwrite(&sc[0], sizeof(snap_class_t), sc.size(), f) == sc.size());
+  ok = ok && (sl.empty() || fwrite(&sl[0], sizeof(snap_label_t), sl.size(), f) == sl.size());
+  ok = ok && (ss.empty() || fwrite(&ss[0], sizeof(snap_state_t), ss.size(), f) == ss.size());
+  ok = ok && (sd.empty() || fwrite(&sd[0], sizeof(snap_doomed_t), sd.size(), f) == sd.size());
+  ok = ok && (strings.empty() || fwrite(&strings[0], 1, strings.size(), f) == strings.size());
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok)
+    remove(filename);
+
+  return ok;
+}
+
+
+bool ActorInfoDictionary::LoadSnapshot(const char *filename, const byte *key)
+{
+  FILE *f = fopen(filename, "rb");
+  if (!f)
+    return false;
+
+  // the whole file in one read
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+
+  if (size < long(sizeof(snap_header_t)))
+    {
+      fclose(f);
+      return false;
+    }
+
+  vector<byte> buf(size);
+  bool ok = fread(&buf[0], size, 1, f) == 1;
+  fclose(f);
+  if (!ok)
+    return false;
+
+  snap_header_t ref;
+  SetHeader(ref, key);
+  const snap_header_t *h = reinterpret_cast<const snap_header_t *>(&buf[0]);
+  if (memcmp(h, &ref, offsetof(snap_header_t, num_classes)))
+    return false; // stale
+
+  if (h->num_classes < 0 || h->num_labels < 0 || h->num_states < 0 || h->num_doomed < 0 || h->strings_size <= 0 ||
+      size != long(sizeof(snap_header_t) +
+		   h->num_classes * sizeof(snap_class_t) + h->num_labels * sizeof(snap_label_t) +
+		   h->num_states * sizeof(snap_state_t) + h->num_doomed * sizeof(snap_doomed_t) + h->strings_size))
+    return false;
+
+  const snap_class_t  *sc = reinterpret_cast<const snap_class_t *>(h + 1);
+  const snap_label_t  *sl = reinterpret_cast<const snap_label_t *>(sc + h->num_classes);
+  const snap_state_t  *ss = reinterpret_cast<const snap_state_t *>(sl + h->num_labels);
+  const snap_doomed_t *sd = reinterpret_cast<const snap_doomed_t *>(ss + h->num_states);
+  const char *strings     = reinterpret_cast<const char *>(sd + h->num_doomed);
+
+  if (strings[h->strings_size - 1])
+    return false;
+
+  // Validate everything before touching the dictionary.
+  int maxstate = NUMSTATES + h->num_states;
+  vector<ActorInfo*> classes(h->num_classes);
+  vector<int> label_first(h->num_labels, -1); // state pool index of each dynamic label
+  int pool = 0;
+
+#define BAD_STR(x)   ((x) < 0 || (x) >= h->strings_size)
+#define BAD_STATE(x) ((x) < -1 || (x) >= maxstate)
+
+  for (int c = 0; c < h->num_classes; c++)
+    {
+      const snap_class_t &s = sc[c];
+      if (BAD_STR(s.name) || BAD_STR(s.obituary) || BAD_STR(s.hitobituary) || BAD_STR(s.modelname) || BAD_STR(s.skinname) ||
+	  s.touchf < -1 || s.touchf >= NUMMOBJTYPES ||
+	  s.first_label < 0 || s.num_labels < 0 || s.first_label + s.num_labels > h->num_labels)
+	return false;
+
+      for (int k = 0; k < 9; k++)
+	if (BAD_STATE(s.states[k]))
+	  return false;
+
+      ActorInfo *a = Find(&strings[s.name]);
+      if (a)
+	{
+	  if (a->mobjtype != s.mobjtype)
+	    return false;
+	}
+      else if (mt_map.count(mobjtype_t(s.mobjtype)))
+	return false;
+
+      classes[c] = a; // NULL means "create"
+
+      for (int j = s.first_label; j < s.first_label + s.num_labels; j++)
+	{
+	  const snap_label_t &l = sl[j];
+	  if (BAD_STATE(l.states) || l.num_states < 0)
+	    return false;
+
+	  if (l.dyn_states && l.states >= 0)
+	    {
+	      if (l.states != NUMSTATES + pool || pool + l.num_states > h->num_states)
+		return false;
+	      label_first[j] = pool;
+	      pool += l.num_states;
+	    }
+	}
+    }
+
+  if (pool != h->num_states)
+    return false;
+
+  for (int k = 0; k < h->num_states; k++)
+    if (BAD_STATE(ss[k].nextstate) || ss[k].action < -1 || ss[k].action >= h->nummnemonics ||
+	ss[k].sprite < 0 || ss[k].sprite >= int(spritenames.size()))
+      return false;
+
+  for (int k = 0; k < h->num_doomed; k++)
+    if (sd[k].classnum < 0 || sd[k].classnum >= h->num_classes)
+      return false;
+
+#undef BAD_STR
+#undef BAD_STATE
+
+  // Looks good. Create the missing classes and allocate the dynamic states.
+  vector<state_t*> pool_states(h->num_states);
+
+  for (int c = 0; c < h->num_classes; c++)
+    {
+      const snap_class_t &s = sc[c];
+      ActorInfo *a = classes[c];
+      if (!a)
+	{
+	  a = classes[c] = new ActorInfo(&strings[s.name]);
+	  a->SetMobjType(mobjtype_t(s.mobjtype));
+	  Insert(a);
+	}
+
+      // discard old states
+      for (unsigned j = 0; j < a->labels.size(); j++)
+	if (a->labels[j].dyn_states && a->labels[j].label_states)
+	  free(a->labels[j].label_states);
+
+      a->labels.resize(s.num_labels);
+      for (int j = 0; j < s.num_labels; j++)
+	{
+	  const snap_label_t &l = sl[s.first_label + j];
+	  ActorInfo::statelabel_t &t = a->labels[j];
+	  memcpy(t.label, l.label, SL_LEN);
+	  memcpy(t.jumplabel, l.jumplabel, SL_LEN);
+	  t.num_states   = l.num_states;
+	  t.jumplabelnum = l.jumplabelnum;
+	  t.jumpoffset   = l.jumpoffset;
+	  t.dyn_states   = l.dyn_states;
+	  t.label_states = NULL;
+
+	  int first = label_first[s.first_label + j];
+	  if (first >= 0 && l.num_states)
+	    {
+	      t.label_states = static_cast<state_t*>(malloc(l.num_states * sizeof(state_t)));
+	      for (int k = 0; k < l.num_states; k++)
+		pool_states[first + k] = &t.label_states[k];
+	    }
+	}
+    }
+
+  // pointer fixups
+#define DECODE(x) ((x) < 0 ? NULL : (x) < NUMSTATES ? &states[x] : pool_states[(x) - NUMSTATES])
+
+  for (int k = 0; k < h->num_states; k++)
+    {
+      const snap_state_t &u = ss[k];
+      state_t *st = pool_states[k];
+      st->sprite    = spritenum_t(u.sprite);
+      st->frame     = u.frame;
+      st->tics      = u.tics;
+      st->action    = (u.action < 0) ? NULL : BEX_DActorMnemonics[u.action].ptr;
+      st->nextstate = DECODE(u.nextstate);
+    }
+
+  for (int c = 0; c < h->num_classes; c++)
+    {
+      const snap_class_t &s = sc[c];
+      ActorInfo *a = classes[c];
+
+      a->obituary     = &strings[s.obituary];
+      a->hitobituary  = &strings[s.hitobituary];
+      a->modelname    = &strings[s.modelname];
+      a->skinname     = &strings[s.skinname];
+      a->game         = s.game;
+      a->spawn_always = s.spawn_always;
+      a->doomednum    = s.doomednum;
+      a->spawnhealth  = s.spawnhealth;
+      a->reactiontime = s.reactiontime;
+      a->radius.setvalue(s.radius);
+      a->height.setvalue(s.height);
+      a->mass         = s.mass;
+      a->speed        = s.speed;
+      a->flags        = s.flags;
+      a->flags2       = s.flags2;
+      a->damage       = s.damage;
+      a->painchance   = s.painchance;
+      for (int k = 0; k < 5; k++)
+	(&a->seesound)[k] = s.sounds[k];
+      for (int k = 0; k < 9; k++)
+	(&a->spawnstate)[k] = DECODE(s.states[k]);
+      a->touchf = (s.touchf < 0) ? NULL : mobjinfo[s.touchf].touchf;
+
+      for (int j = 0; j < s.num_labels; j++)
+	{
+	  ActorInfo::statelabel_t &t = a->labels[j];
+	  if (!t.label_states)
+	    t.label_states = DECODE(sl[s.first_label + j].states);
+	}
+    }
+
+#undef DECODE
+
+  doomed_map.clear();
+  for (int k = 0; k < h->num_doomed; k++)
+    doomed_map.insert(doomed_map_t::value_type(sd[k].doomednum, classes[sd[k].classnum]));
+
+  return true;
+}
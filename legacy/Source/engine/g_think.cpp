@@ -21,7 +21,11 @@
 /// \file
 /// \brief TypeInfo and Thinker class implementation
 
+#include <algorithm>
+
+#include "doomdef.h"
 #include "g_think.h"
+#include "g_map.h"
 #include "m_archive.h"
 #include "z_zone.h"
 
@@ -48,6 +52,8 @@ TypeInfo::TypeInfo(const char *n, thinker_factory_t f, TypeInfo *p)
   name = n;
   factory = f;
   parent = p;
+
+  size = allocated = live = peak = 0;
 }
 
 
@@ -63,6 +69,42 @@ TypeInfo *TypeInfo::Find(unsigned c)
 }
 
 
+static bool CompareAllocated(const TypeInfo *a, const TypeInfo *b)
+{
+  return a->allocated > b->allocated;
+}
+
+void TypeInfo::PrintStats()
+{
+  static map<unsigned, TypeInfo*>& id_ref = TypeInfo::id_map();
+  vector<TypeInfo*> types;
+
+  for (map<unsigned, TypeInfo*>::iterator i = id_ref.begin(); i != id_ref.end(); i++)
+    if (i->second->allocated)
+      types.push_back(i->second);
+
+  // churning classes first
+  sort(types.begin(), types.end(), CompareAllocated);
+
+  CONS_Printf("\2Thinker classes\n");
+  CONS_Printf("%-20s %5s %9s %7s %7s\n", "class", "size", "allocated", "live", "peak");
+  int n = types.size();
+  for (int i=0; i<n; i++)
+    {
+      TypeInfo *t = types[i];
+      CONS_Printf("%-20s %5d %9d %7d %7d\n", t->name, t->size, t->allocated, t->live, t->peak);
+    }
+}
+
+
+void Command_ThinkerInfo_f()
+{
+  TypeInfo::PrintStats();
+  CONS_Printf("\n");
+  mempool_t::PrintAll();
+}
+
+
 // Since this class has no parent, we must implement it like this:
 TypeInfo Thinker::_type("Thinker", Thinker::Create, NULL);
 
@@ -124,12 +166,102 @@ Thinker *Thinker::Unserialize(LArchive &a)
 }
 
 
-void *Thinker::operator new (size_t size)
+//==========================================================
+// thinkerbatch_t
+
+IMPLEMENT_CLASS(thinkerbatch_t, Thinker);
+
+thinkerbatch_t::thinkerbatch_t()
+{
+  think = NULL;
+  live = 0;
+}
+
+thinkerbatch_t::thinkerbatch_t(batchthink_t f)
+{
+  think = f;
+  live = 0;
+}
+
+// The batch owns its members.
+thinkerbatch_t::~thinkerbatch_t()
+{
+  int n = members.size();
+  for (int i=0; i<n; i++)
+    if (members[i])
+      delete members[i];
+}
+
+// Batches are unbatched before serialization, see Map::Serialize.
+int thinkerbatch_t::Marshal(LArchive &a)
+{
+  return 0;
+}
+
+
+void thinkerbatch_t::Think()
+{
+  if (live == 0)
+    {
+      mp->RemoveThinker(this); // all gone
+      return;
+    }
+
+  int n = members.size();
+  if (live < n/2)
+    {
+      // squeeze out the removed members, they are not deleted here
+      vector<Thinker *>::iterator last = remove(members.begin(), members.end(), (Thinker *)NULL);
+      members.erase(last, members.end());
+      n = live;
+    }
+
+  think(&members[0], n); // members may be removed but not added during this
+}
+
+
+void thinkerbatch_t::ClientThink()
+{
+  int n = members.size();
+  for (int i=0; i<n; i++)
+    if (members[i])
+      members[i]->ClientThink();
+}
+
+
+// Removals are rare (finished light fades), so a linear search is enough.
+void thinkerbatch_t::Remove(Thinker *t)
 {
-  return Z_Malloc(size, PU_LEVSPEC, NULL);    
+  int n = members.size();
+  for (int i=0; i<n; i++)
+    if (members[i] == t)
+      {
+	members[i] = NULL;
+	live--;
+	return;
+      }
+
+  I_Error("thinkerbatch_t: Thinker not found!\n");
+}
+
+
+// All Thinkers are allocated from a common slab pool. Thinkers of the same size
+// (e.g. puffs, blood and missiles, or the various sector movers) share a free list,
+// so the storage of removed Thinkers is immediately reused by new ones.
+static mempool_t thinker_pool("Thinkers", PU_LEVSPEC);
+
+void *Thinker::Alloc(size_t size, TypeInfo *t)
+{
+  t->size = size;
+  t->allocated++;
+  if (++t->live > t->peak)
+    t->peak = t->live;
+
+  return thinker_pool.Alloc(size);
 }
 
-void Thinker::operator delete (void *mem)
+void Thinker::Free(void *mem, size_t size, TypeInfo *t)
 {
-  Z_Free(mem);
+  t->live--;
+  thinker_pool.Free(mem, size);
 }
@@ -127,11 +127,15 @@ void GameType::performScopeQuery(GhostConnection *c)
 	  
 	  // TODO for now, ignore PVS, scope all stuff in Map
 	  // TODO use IterateThinkers?
-	  for (Thinker *t = m->thinkercap.next; t != &m->thinkercap; t = t->next)
+	  for (int r = 0; r < 2; r++)
 	    {
-	      Actor *a = t->Inherits<Actor>();
-	      if (a)
-		c->objectInScope(a);
+	      Thinker &cap = r ? m->dormantcap : m->thinkercap;
+	      for (Thinker *t = cap.next; t != &cap; t = t->next)
+		{
+		  Actor *a = t->Inherits<Actor>();
+		  if (a)
+		    c->objectInScope(a);
+		}
 	    }
 	}
     }
@@ -125,7 +125,7 @@ void Camera::ResetCamera(Actor *p)
 
 void Camera::Think()
 {
-  PlayerPawn *o = reinterpret_cast<PlayerPawn*>(owner);
+  PlayerPawn *o = reinterpret_cast<PlayerPawn*>(owner.get());
   if (!o || !o->player || o->player->pov != this)
     {
       // We're no longer pov and thus unnecessary.
@@ -63,7 +63,7 @@ static dirtype_t diags[] =
 
 void FastMonster_OnChange()
 {
-  static bool fast=false;
+  static bool fast=false; // only changed from the console, between tics
   static const struct {
     mobjtype_t type;
     float speed[2];
@@ -221,17 +221,17 @@ bool P_CheckSpecialDeath(DActor *m, int dtype)
 // sound blocking lines cut off traversal.
 //
 
-static Actor   *soundtarget;
+static thread_local Actor   *soundtarget;
 
-static void P_RecursiveSound(sector_t *sec, int soundblocks)
+static void P_RecursiveSound(spatialquery_t &q, sector_t *sec, int soundblocks)
 {
   // wake up all monsters in this sector
-  if (sec->validcount == validcount && sec->soundtraversed <= soundblocks)
+  if (!q.VisitSector(sec - q.mp->sectors) && sec->soundtraversed <= soundblocks)
     return; // already flooded with louder sound
 
-  sec->validcount = validcount;
   sec->soundtraversed = soundblocks;
   sec->soundtarget = soundtarget;
+  q.mp->WakeSector(sec);
 
   for (int i=0; i < sec->linecount; i++)
     {
@@ -255,10 +255,10 @@ static void P_RecursiveSound(sector_t *sec, int soundblocks)
       if (check->flags & ML_SOUNDBLOCK)
         {
 	  if (soundblocks <= 0)
-	    P_RecursiveSound(other, soundblocks+1);
+	    P_RecursiveSound(q, other, soundblocks+1);
         }
       else
-	P_RecursiveSound(other, soundblocks);
+	P_RecursiveSound(q, other, soundblocks);
     }
 }
 
@@ -269,8 +269,8 @@ static void P_RecursiveSound(sector_t *sec, int soundblocks)
 void P_NoiseAlert(Actor *target, Actor *emitter)
 {
   soundtarget = target;
-  validcount++;
-  P_RecursiveSound(emitter->subsector->sector, 0);
+  query_scope_t q(emitter->mp);
+  P_RecursiveSound(*q, emitter->subsector->sector, 0);
 }
 
 
@@ -576,8 +576,8 @@ void DActor::P_NewChaseDir()
 
 
 
-static Actor *looker;
-static int search_count;
+static thread_local Actor *looker;
+static thread_local int search_count;
 
 // TODO save CPU, add realism, use blockmap or BSP to only seek surroundings
 static bool IT_FindEnemies(Thinker *th)
@@ -1325,8 +1325,8 @@ void A_SkelFist(DActor  *actor)
 // PIT_VileCheck
 // Detect a corpse that could be raised.
 //
-static DActor *corpsehit, *vileobj;
-static fixed_t  viletryx, viletryy;
+static thread_local DActor *corpsehit, *vileobj;
+static thread_local fixed_t  viletryx, viletryy;
 
 bool PIT_VileCheck(Actor *th)
 {
@@ -1929,10 +1929,8 @@ void A_BrainSpit(DActor *mo)
 {
   Map *m = mo->mp;
 
-  static int easy = 0;
-
-  easy ^= 1;
-  if (game.skill <= sk_easy && (!easy))
+  m->braineasy = !m->braineasy;
+  if (game.skill <= sk_easy && !m->braineasy)
     return;
 
   int n = m->braintargets.size();
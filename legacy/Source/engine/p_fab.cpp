@@ -413,7 +413,7 @@ int MT_LIGHTNING_ZAP_touchfunc(DActor *d, Actor *p)
 
   if (d->owner)
     {
-      DActor *lmo = reinterpret_cast<DActor*>(d->owner);
+      DActor *lmo = reinterpret_cast<DActor*>(d->owner.get());
   
       if (lmo->type == MT_LIGHTNING_FLOOR)
 	{
@@ -27,6 +27,7 @@
 #include "g_map.h"
 
 #include "p_spec.h"
+#include "p_maputl.h"
 #include "sounds.h"
 #include "tables.h"
 
@@ -671,8 +672,7 @@ int Map::EV_BuildHexenStairs(unsigned tag, int type, fixed_t speed, fixed_t step
       sec->special = 0;
     }
 
-  extern int validcount;
-  validcount++;
+  query_scope_t q(this);
 
   while (!stairqueue.empty())
     {
@@ -694,26 +694,22 @@ int Map::EV_BuildHexenStairs(unsigned tag, int type, fixed_t speed, fixed_t step
 
 	  sector_t *tsec = sec->lines[i]->frontsector;
 	  if ((tsec->special == phase + SS_Stairs_Special1) && !tsec->floordata
-	      && tsec->floorpic == texture && tsec->validcount != validcount)
+	      && tsec->floorpic == texture && q->VisitSector(tsec - sectors))
 	    {
 	      s.sector = tsec;
 	      s.phase = phase^1;
 	      // s.height is OK
 	      stairqueue.push_back(s);
-
-	      tsec->validcount = validcount;
 	      //tsec->special = 0;
 	    }
 	  tsec = sec->lines[i]->backsector;
 	  if ((tsec->special == phase + SS_Stairs_Special1) && !tsec->floordata
-	      && tsec->floorpic == texture && tsec->validcount != validcount)
+	      && tsec->floorpic == texture && q->VisitSector(tsec - sectors))
 	    {
 	      s.sector = tsec;
 	      s.phase = phase^1;
 	      // s.height is OK
 	      stairqueue.push_back(s);
-
-	      tsec->validcount = validcount;
 	      //tsec->special = 0;
 	    }
 	}
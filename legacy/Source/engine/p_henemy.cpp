@@ -1276,7 +1276,7 @@ void A_RemovePod(DActor *actor)
 {
   if (actor->owner)
     {
-      DActor *mo = (DActor *)actor->owner;
+      DActor *mo = (DActor *)actor->owner.get();
       if (mo->special1 > 0)
 	mo->special1--;
     }
@@ -580,6 +580,9 @@ bool Actor::Damage(Actor *inflictor, Actor *source, int damage, int dtype)
 
 bool DActor::Damage(Actor *inflictor, Actor *source, int damage, int dtype)
 {
+  if (eflags & MFE_DORMANT)
+    mp->WakeActor(this);
+
   if (!(flags & MF_SHOOTABLE))
     return false; // shouldn't happen...
 
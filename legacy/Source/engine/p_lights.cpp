@@ -165,6 +165,14 @@ void lightfx_t::Think()
 }
 
 
+// Non-virtual Think for a batch of lightfx_t's.
+void lightfx_t::ThinkBatch(Thinker *const *t, int n)
+{
+  for (int i=0; i<n; i++)
+    if (t[i])
+      static_cast<lightfx_t *>(t[i])->lightfx_t::Think();
+}
+
 
 void Map::SpawnStrobeLight(sector_t *sec, short brighttime, short darktime, bool inSync)
 {
@@ -394,6 +402,15 @@ void phasedlight_t::Think()
 }
 
 
+// Non-virtual Think for a batch of phasedlight_t's.
+void phasedlight_t::ThinkBatch(Thinker *const *t, int n)
+{
+  for (int i=0; i<n; i++)
+    if (t[i])
+      static_cast<phasedlight_t *>(t[i])->phasedlight_t::Think();
+}
+
+
 phasedlight_t::phasedlight_t(Map *m, sector_t *s, int b, int ind)
   : sectoreffect_t(m, s)
 {
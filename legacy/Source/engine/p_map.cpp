@@ -105,13 +105,13 @@ extern int boomsupport;
 //  Radius iteration
 //===========================================
 
-static Actor *tmthing; // initiator for iteration, used by some PIT_* functions
-static bbox_t tmb; // bounding box, used by line PIT_* functions
+static thread_local Actor *tmthing; // initiator for iteration, used by some PIT_* functions
+static thread_local bbox_t tmb; // bounding box, used by line PIT_* functions
 
-// iterates lines around (x,y) using func
+// iterates lines crossing the box around (x,y) using func
 bool blockmap_t::IterateLinesRadius(fixed_t x, fixed_t y, fixed_t radius, line_iterator_t func)
 {
-  validcount++; // used by LinesIterator to make sure we only process a line once
+  query_scope_t q(parent_map); // used by LinesIterator to make sure we only process a line once
   tmb.Set(x, y, radius);
 
   // check lines within box
@@ -122,14 +122,14 @@ bool blockmap_t::IterateLinesRadius(fixed_t x, fixed_t y, fixed_t radius, line_i
 
   for (int bx=xl; bx<=xh; bx++)
     for (int by=yl; by<=yh; by++)
-      if (!LinesIterator(bx, by, func))
+      if (!LinesBoxIterator(*q, bx, by, tmb, func))
 	return false;
 
   return true;
 }
 
 
-static fixed_t tmx, tmy; // temporary tmthing position, used by some thing PIT_* functions
+static thread_local fixed_t tmx, tmy; // temporary tmthing position, used by some thing PIT_* functions
 
 
 // iterates things around (x,y) using func
@@ -485,7 +485,7 @@ void Actor::CheckLineImpact(vector<line_t*> &spechit)
 
 
 /// Data for PIT_CheckThing and PIT_CheckLine, also holds the return value of last call to Actor::CheckPosition()
-static position_check_t PC_data;
+static thread_local position_check_t PC_data;
 
 /// \brief Checks if an Actor is physically collided by another.
 /// \ingroup g_collision
@@ -574,15 +574,9 @@ static bool PIT_CheckThing(Actor *thing)
   Adjusts PC_data.op.bottom and PC_data.op.top as lines are contacted.
   Sets PC_data.block_line, pushes lines, adds them to spechit vector.
 */
-static bool PIT_CheckLine(line_t *ld)
+static bool PIT_CheckLine(spatialquery_t &q, line_t *ld)
 {
-  if (!tmb.BoxTouchBox(ld->bbox))
-    return true;
-
-  if (tmb.BoxOnLineSide(ld) != -1)
-    return true;
-
-  // A line has been hit.
+  // A line has been hit (IterateLinesRadius only gives us lines crossing tmb).
 
   // The moving thing's destination position will cross the given line.
   // If this should not be allowed, return false.
@@ -615,18 +609,12 @@ static bool PIT_CheckLine(line_t *ld)
   // several line_t's and hence can appear here more than once.
 
   sector_t *s = ld->frontsector;
-  if (s->validcount != validcount)
-    {
-      s->validcount = validcount;
-      PC_data.op.SubtractFromOpening(tmthing, s);
-    }
+  if (q.VisitSector(s - q.mp->sectors))
+    PC_data.op.SubtractFromOpening(tmthing, s);
 
   s = ld->backsector;
-  if (s->validcount != validcount)
-    {
-      s->validcount = validcount;
-      PC_data.op.SubtractFromOpening(tmthing, s);
-    }
+  if (q.VisitSector(s - q.mp->sectors))
+    PC_data.op.SubtractFromOpening(tmthing, s);
 
   /*
     // No early out, checked at Actor::TryMove
@@ -727,10 +715,10 @@ bool Actor::TestLocation(const vec_t<fixed_t> &p)
 // Allows the player to slide along any angled walls.
 //==========================================================================
 
-static float   bestslidefrac;
-static line_t *bestslideline;
-static Actor  *slidemo;
-static vec_t<fixed_t> tmmove;
+static thread_local float   bestslidefrac;
+static thread_local line_t *bestslideline;
+static thread_local Actor  *slidemo;
+static thread_local vec_t<fixed_t> tmmove;
 
 
 /// \brief Tries sliding along the intercept_t
@@ -738,7 +726,7 @@ static vec_t<fixed_t> tmmove;
 /*!
   When a move is blocked by an unpassable line, try sliding along it.
 */
-static bool PTR_SlideTraverse(intercept_t *in)
+static bool PTR_SlideTraverse(spatialquery_t &q, intercept_t *in)
 {
   line_t *li = in->line;
 
@@ -839,6 +827,7 @@ void Actor::SlideMove(fixed_t nx, fixed_t ny)
 
   slidemo = this;
   int hitcount = 0;
+  query_scope_t q(mp);
 
   const float fudge = 1.0/32;   // TODO find a better way
 
@@ -874,13 +863,13 @@ void Actor::SlideMove(fixed_t nx, fixed_t ny)
 
   // find bestslideline and -frac
   corner.x = leadx; corner.y = leady;
-  mp->blockmap->PathTraverse(corner, corner + delta, PT_ADDLINES, PTR_SlideTraverse);
+  mp->blockmap->PathTraverse(*q, corner, corner + delta, PT_ADDLINES, PTR_SlideTraverse);
 
   corner.x = trailx; corner.y = leady;
-  mp->blockmap->PathTraverse(corner, corner + delta, PT_ADDLINES, PTR_SlideTraverse);
+  mp->blockmap->PathTraverse(*q, corner, corner + delta, PT_ADDLINES, PTR_SlideTraverse);
 
   corner.x = leadx; corner.y = traily;
-  mp->blockmap->PathTraverse(corner, corner + delta, PT_ADDLINES, PTR_SlideTraverse);
+  mp->blockmap->PathTraverse(*q, corner, corner + delta, PT_ADDLINES, PTR_SlideTraverse);
 
   // move up to the wall
   if (bestslidefrac == 2)
@@ -939,7 +928,7 @@ void Actor::SlideMove(fixed_t nx, fixed_t ny)
 /*!
   Uses the slidemove static variables.
 */
-static bool PTR_BounceTraverse(intercept_t *in)
+static bool PTR_BounceTraverse(spatialquery_t &q, intercept_t *in)
 {
   line_t *li = in->line;
 
@@ -994,7 +983,8 @@ void Actor::BounceWall(fixed_t nx, fixed_t ny)
   bestslideline = NULL;
 
   corner.x = leadx; corner.y = leady;
-  mp->blockmap->PathTraverse(corner, corner + delta, PT_ADDLINES, PTR_BounceTraverse);
+  query_scope_t q(mp);
+  mp->blockmap->PathTraverse(*q, corner, corner + delta, PT_ADDLINES, PTR_BounceTraverse);
 
   if (!bestslideline)
     return;
@@ -1028,17 +1018,17 @@ void Actor::BounceWall(fixed_t nx, fixed_t ny)
 //==========================================================================
 
 /// i/o variables
-static Actor  *shootthing;   ///< Instigator of the trace.
-static bool    interact;     ///< shoot or just trace?
+static thread_local Actor  *shootthing;   ///< Instigator of the trace.
+static thread_local bool    interact;     ///< shoot or just trace?
 
-static bool    hitsky;       ///< Did we hit a sky plane or wall?
-static Actor  *target_actor; ///< Actor that got hit (or NULL)
-line_t *target_line;  ///< line_t that got hit (or NULL)
+static thread_local bool    hitsky;       ///< Did we hit a sky plane or wall?
+static thread_local Actor  *target_actor; ///< Actor that got hit (or NULL)
+thread_local line_t *target_line;  ///< line_t that got hit (or NULL)
 
-static float bottomsine, topsine; // vertical aiming range
+static thread_local float bottomsine, topsine; // vertical aiming range
 
 
-mobjtype_t PuffType = MT_PUFF; ///< for Actor::LineAttack
+thread_local mobjtype_t PuffType = MT_PUFF; ///< for Actor::LineAttack
 
 
 /// \brief Aiming up and down for missile attacks.
@@ -1048,8 +1038,10 @@ mobjtype_t PuffType = MT_PUFF; ///< for Actor::LineAttack
   Sets target_actor when a target is found.
   Returns true if the thing is not shootable, else continue through..
 */
-static bool PTR_AimTraverse(intercept_t *in)
+static bool PTR_AimTraverse(spatialquery_t &q, intercept_t *in)
 {
+  trace_t &trace = q.trace;
+
   float dist = trace.length * in->frac; // 3D distance
 
   if (in->isaline)
@@ -1205,10 +1197,11 @@ Actor *Actor::AimLineAttack(angle_t ang, float distance, float& sinpitch)
   fixed_t temp = distance * Cos(pitch); // XY length
   vec_t<fixed_t> delta(temp * Cos(ang), temp * Sin(ang), distance * aimsine);
 
-  mp->blockmap->PathTraverse(s, s+delta, PT_ADDLINES | PT_ADDTHINGS, PTR_AimTraverse);
+  query_scope_t q(mp);
+  mp->blockmap->PathTraverse(*q, s, s+delta, PT_ADDLINES | PT_ADDTHINGS, PTR_AimTraverse);
 
   // found a target?
-  sinpitch = trace.sin_pitch; // unchanged if no target was found
+  sinpitch = q->trace.sin_pitch; // unchanged if no target was found
   return target_actor;
 }
 
@@ -1249,10 +1242,10 @@ bool trace_t::HitZPlane(sector_t *s)
   Sets target_actor or target_line if an actor or wall is hit.
   \return true if the trace continues after this intercept
 */
-static bool PTR_LineTrace(intercept_t *in)
+static bool PTR_LineTrace(spatialquery_t &q, intercept_t *in)
 {
-  // we need the right Map * from somewhere.
-  Map *m = trace.mp;
+  trace_t &trace = q.trace;
+  Map *m = q.mp;
 
   // NOTE: The blockmap_t::PathTraverse tracing system works strictly in the XY plane.
   // Hence a Z-plane (floor, ceiling, fake floor) may actually intercept the trace
@@ -1348,7 +1341,9 @@ static bool PTR_LineTrace(intercept_t *in)
 Actor *Actor::LineAttack(angle_t ang, float distance, float sine, int damage, int dtype)
 {
   // do the trace
-  LineTrace(ang, distance, sine, damage >= 0);
+  query_scope_t q(mp);
+  LineTrace(*q, ang, distance, sine, damage >= 0);
+  trace_t &trace = q->trace;
 
   if (hitsky)
     return NULL;
@@ -1433,13 +1428,14 @@ Actor *Actor::LineAttack(angle_t ang, float distance, float sine, int damage, in
 /// \ingroup g_trace
 /*!
   The function performs a trace starting from (roughly) the center of the actor.
+  \param q query context, holds the finished trace afterwards
   \param ang yaw angle for the attack
   \param distance max range for the projectile (including z direction!)
   \param sine sin(pitch) for the attack
   \param inter does the trace cause interactions in the Map?
   \return pointer to the target Actor or NULL if something else (line, plane, nothing) was hit
 */
-Actor *Actor::LineTrace(angle_t ang, float distance, float sine, bool inter)
+Actor *Actor::LineTrace(spatialquery_t &q, angle_t ang, float distance, float sine, bool inter)
 {
   shootthing = this;
   interact = inter;
@@ -1457,8 +1453,7 @@ Actor *Actor::LineTrace(angle_t ang, float distance, float sine, bool inter)
   // end point
   vec_t<fixed_t> delta(temp * Cos(ang), temp * Sin(ang), fixed_t(sine*distance));
 
-  trace.mp = mp; // HACK: PTR_LineTrace needs a Map reference
-  mp->blockmap->PathTraverse(s, s+delta, PT_ADDLINES | PT_ADDTHINGS, PTR_LineTrace);
+  mp->blockmap->PathTraverse(q, s, s+delta, PT_ADDLINES | PT_ADDTHINGS, PTR_LineTrace);
 
   return target_actor;
 }
@@ -1469,16 +1464,18 @@ Actor *Actor::LineTrace(angle_t ang, float distance, float sine, bool inter)
 //   Blood spawning
 //==========================================================================
 
-static Actor   *bloodthing;
-static fixed_t  blood_x, blood_y;
+static thread_local Actor   *bloodthing;
+static thread_local fixed_t  blood_x, blood_y;
 
 /// \brief Spray blood splats on walls.
 /// \ingroup g_ptr
 /*!
   Adds a wall splat on the first solid wall encountered.
 */
-static bool PTR_BloodTraverse(intercept_t *in)
+static bool PTR_BloodTraverse(spatialquery_t &q, intercept_t *in)
 {
+  trace_t &trace = q.trace;
+
   if (in->isaline)
     {
       line_t *li = in->line;
@@ -1541,6 +1538,7 @@ void Map::SpawnBloodSplats(const vec_t<fixed_t>& r, int damage, fixed_t px, fixe
   blood_x = r.x;
   blood_y = r.y;
 
+  query_scope_t q(this);
   for (int i=0; i<numsplats; i++)
     {
       // find random angle between 0-180deg centered on damage angle
@@ -1548,7 +1546,7 @@ void Map::SpawnBloodSplats(const vec_t<fixed_t>& r, int damage, fixed_t px, fixe
 
       vec_t<fixed_t> delta(distance * Cos(anglesplat), distance * Sin(anglesplat), 0);
 
-      blockmap->PathTraverse(r, r+delta, PT_ADDLINES, PTR_BloodTraverse);
+      blockmap->PathTraverse(*q, r, r+delta, PT_ADDLINES, PTR_BloodTraverse);
     }
 
 #ifdef FLOORSPLATS
@@ -1563,14 +1561,14 @@ void Map::SpawnBloodSplats(const vec_t<fixed_t>& r, int damage, fixed_t px, fixe
 //  Using linedefs
 //==========================================================================
 
-static PlayerPawn *usething;
+static thread_local PlayerPawn *usething;
 
 /// \brief Using special line_t's
 /// \ingroup g_ptr
 /*!
   Called when a player has pushed USE.
 */
-static bool PTR_UseTraverse(intercept_t *in)
+static bool PTR_UseTraverse(spatialquery_t &q, intercept_t *in)
 {
   line_t *line = in->line;
   CONS_Printf("Line %d: s = %d, tag = %d, flags = %x\n", line-usething->mp->lines, line->special, line->tag, line->flags);
@@ -1619,7 +1617,8 @@ void PlayerPawn::UseLines()
 
   vec_t<fixed_t> delta(USERANGE * Cos(yaw), USERANGE * Sin(yaw), 0);
 
-  mp->blockmap->PathTraverse(pos, pos+delta, PT_ADDLINES, PTR_UseTraverse);
+  query_scope_t q(mp);
+  mp->blockmap->PathTraverse(*q, pos, pos+delta, PT_ADDLINES, PTR_UseTraverse);
 }
 
 
@@ -1627,16 +1626,16 @@ void PlayerPawn::UseLines()
 //  Puzzle item usage
 //==========================================================================
 
-static PlayerPawn *PuzzleItemUser;
-static int  PuzzleItemType;
-static bool PuzzleActivated;
+static thread_local PlayerPawn *PuzzleItemUser;
+static thread_local int  PuzzleItemType;
+static thread_local bool PuzzleActivated;
 
 /// \brief Using Hexen puzzle items.
 /// \ingroup g_ptr
 /*!
   Called when a player activates a puzzle item.
 */
-static bool PTR_PuzzleItemTraverse(intercept_t *in)
+static bool PTR_PuzzleItemTraverse(spatialquery_t &q, intercept_t *in)
 {
   const int USE_PUZZLE_ITEM_SPECIAL = 129;
 
@@ -1691,7 +1690,8 @@ bool PlayerPawn::UsePuzzleItem(int type)
 
   vec_t<fixed_t> delta(USERANGE * Cos(yaw), USERANGE * Sin(yaw), 0);
 
-  mp->blockmap->PathTraverse(pos, pos+delta, PT_ADDLINES | PT_ADDTHINGS, PTR_PuzzleItemTraverse);
+  query_scope_t q(mp);
+  mp->blockmap->PathTraverse(*q, pos, pos+delta, PT_ADDLINES | PT_ADDTHINGS, PTR_PuzzleItemTraverse);
   return PuzzleActivated;
 }
 
@@ -1700,7 +1700,7 @@ bool PlayerPawn::UsePuzzleItem(int type)
 // RADIUS ATTACK
 //==========================================================================
 
-static struct
+static thread_local struct
 {
   Actor  *owner; // the creature that caused the explosion at b
   Actor  *b;
@@ -1856,8 +1856,8 @@ static bool P_ThingHeightClip(Actor *thing)
   return true;
 }
 
-static int  crushdamage;
-static bool nofit;
+static thread_local int  crushdamage;
+static thread_local bool nofit;
 
 
 /// \brief Checks if an Actor is affected by a sector_t height change.
@@ -1867,6 +1867,9 @@ static bool nofit;
 */
 static bool PIT_ChangeSector(Actor *thing)
 {
+  if (thing->eflags & MFE_DORMANT)
+    thing->mp->WakeActor(thing);
+
   if (P_ThingHeightClip(thing))
     {
       // keep checking
@@ -1952,6 +1955,9 @@ bool Map::CheckSector(sector_t *sector, int crunch)
     return ChangeSector(sector,crunch);
   */
 
+  // the floor or ceiling has moved, stale sight results must not be used
+  sector->lastmove = ++sector_moves;
+
   nofit = false;
   crushdamage = crunch;
 
@@ -2014,7 +2020,7 @@ bool Map::CheckSector(sector_t *sector, int crunch)
 //  Sector lists
 //==========================================================================
 
-static msecnode_t *sector_list = NULL;
+static thread_local msecnode_t *sector_list = NULL;
 
 /// \brief Adds sectors to the touching_sectorlist of an Actor.
 /// \ingroup g_pit
@@ -2024,15 +2030,9 @@ static msecnode_t *sector_list = NULL;
   at this location, so don't bother with checking impassable or
   blocking lines.
 */
-static bool PIT_GetSectors(line_t *ld)
+static bool PIT_GetSectors(spatialquery_t &q, line_t *ld)
 {
-  if (!tmb.BoxTouchBox(ld->bbox))
-    return true;
-
-  if (tmb.BoxOnLineSide(ld) != -1)
-    return true;
-
-  // This line crosses through the object.
+  // This line crosses through the object (IterateLinesRadius only gives us lines crossing tmb).
 
   // Collect the sector(s) from the line and add to the
   // sector_list you're examining. If the Thing ends up being
@@ -2211,14 +2211,9 @@ void P_ThrustSpike(Actor *actor)
 
 
 // ok if line does not touch the box (or is not blocking)
-bool PIT_BBoxFit(line_t *ld)
+bool PIT_BBoxFit(spatialquery_t &q, line_t *ld)
 {
-  if (!tmb.BoxTouchBox(ld->bbox))
-    return true;
-
-  if (tmb.BoxOnLineSide(ld) != -1)
-    return true;
-
+  // IterateLinesRadius only gives us lines crossing tmb
   if (ld->flags & ML_BLOCKING)
     return false;
 
@@ -25,12 +25,17 @@
 /// Intercepts and traces.
 /// Functions for manipulating msecnode_t threads.
 
+#include <algorithm>
+#include <chrono>
+#include <deque>
 #include <vector>
 
 #include "doomdef.h"
+#include "command.h"
 #include "g_actor.h"
 #include "g_map.h"
 #include "g_blockmap.h"
+#include "g_player.h"
 
 #include "m_bbox.h"
 #include "p_polyobj.h"
@@ -59,23 +64,29 @@
 */
 int P_PointOnLineSide(const fixed_t x, const fixed_t y, const line_t *line)
 {
-  if (!line->dx)
+  return P_PointOnLineSide(x, y, line->v1->x, line->v1->y, line->dx, line->dy);
+}
+
+/// Same as above, for a line starting from (lx, ly) with the direction (ldx, ldy).
+int P_PointOnLineSide(const fixed_t x, const fixed_t y, const fixed_t lx, const fixed_t ly, const fixed_t ldx, const fixed_t ldy)
+{
+  if (!ldx)
     {
-      if (x <= line->v1->x)
-	return line->dy > 0;
+      if (x <= lx)
+	return ldy > 0;
 
-      return line->dy < 0;
+      return ldy < 0;
     }
-  if (!line->dy)
+  if (!ldy)
     {
-      if (y <= line->v1->y)
-	return line->dx < 0;
+      if (y <= ly)
+	return ldx < 0;
 
-      return line->dx > 0;
+      return ldx > 0;
     }
 
-  fixed_t dx = x - line->v1->x;
-  fixed_t dy = y - line->v1->y;
+  fixed_t dx = x - lx;
+  fixed_t dy = y - ly;
 
   // original formula, not accurate with short lines
   /*
@@ -83,8 +94,8 @@ int P_PointOnLineSide(const fixed_t x, const fixed_t y, const line_t *line)
   fixed_t right = dy * (line->dx >> 16);
   */
 
-  Sint64 left  = line->dy.value() * dx.value();
-  Sint64 right = line->dx.value() * dy.value();
+  Sint64 left  = ldy.value() * dx.value();
+  Sint64 right = ldx.value() * dy.value();
 
   return (right >= left); // backside?
 }
@@ -237,16 +248,22 @@ divline_t::divline_t(const Actor *a)
   \return side number, 0 or 1, or -1 if box crosses the line
 */
 int bbox_t::BoxOnLineSide(const line_t *ld) const
+{
+  return BoxOnLineSide(ld->v1->x, ld->v1->y, ld->dx, ld->dy, ld->slopetype);
+}
+
+/// Same as above, for a line starting from (x, y) with the direction (dx, dy).
+int bbox_t::BoxOnLineSide(fixed_t x, fixed_t y, fixed_t dx, fixed_t dy, int slopetype) const
 {
   int         p1;
   int         p2;
 
-  switch (ld->slopetype)
+  switch (slopetype)
     {
     case ST_HORIZONTAL:
-      p1 = box[BOXTOP] > ld->v1->y;
-      p2 = box[BOXBOTTOM] > ld->v1->y;
-      if (ld->dx < 0)
+      p1 = box[BOXTOP] > y;
+      p2 = box[BOXBOTTOM] > y;
+      if (dx < 0)
         {
 	  p1 ^= 1;
 	  p2 ^= 1;
@@ -254,9 +271,9 @@ int bbox_t::BoxOnLineSide(const line_t *ld) const
       break;
 
     case ST_VERTICAL:
-      p1 = box[BOXRIGHT] < ld->v1->x;
-      p2 = box[BOXLEFT] < ld->v1->x;
-      if (ld->dy < 0)
+      p1 = box[BOXRIGHT] < x;
+      p2 = box[BOXLEFT] < x;
+      if (dy < 0)
         {
 	  p1 ^= 1;
 	  p2 ^= 1;
@@ -264,16 +281,16 @@ int bbox_t::BoxOnLineSide(const line_t *ld) const
       break;
 
     case ST_POSITIVE:
-      p1 = P_PointOnLineSide (box[BOXLEFT], box[BOXTOP], ld);
-      p2 = P_PointOnLineSide (box[BOXRIGHT], box[BOXBOTTOM], ld);
+      p1 = P_PointOnLineSide (box[BOXLEFT], box[BOXTOP], x, y, dx, dy);
+      p2 = P_PointOnLineSide (box[BOXRIGHT], box[BOXBOTTOM], x, y, dx, dy);
       break;
 
     case ST_NEGATIVE:
-      p1 = P_PointOnLineSide (box[BOXRIGHT], box[BOXTOP], ld);
-      p2 = P_PointOnLineSide (box[BOXLEFT], box[BOXBOTTOM], ld);
+      p1 = P_PointOnLineSide (box[BOXRIGHT], box[BOXTOP], x, y, dx, dy);
+      p2 = P_PointOnLineSide (box[BOXLEFT], box[BOXBOTTOM], x, y, dx, dy);
       break;
     default :
-      I_Error("P_BoxOnLineSide: unknow slopetype %d\n",ld->slopetype);
+      I_Error("P_BoxOnLineSide: unknow slopetype %d\n", slopetype);
       return -1;
     }
 
@@ -364,84 +381,6 @@ sector_t::zcheck_t sector_t::CheckZ(fixed_t z)
 
 
 
-static list<range_t> Line_openings; // sorted from low to high
-
-
-list<range_t> *sector_t::FindLineOpeningsInRange(const range_t& in)
-{
-  Line_openings.clear();
-
-  // start chopping the range up with sector planes
-
-  range_t r = in;
-
-  if (floorheight > r.low)
-    r.low = floorheight;
-
-  if (ceilingheight < r.high)
-    r.high = ceilingheight;
-
-  if (r.high <= r.low)
-    return &Line_openings; // no opening
-
-  Line_openings.push_back(r);
-
-  for (ffloor_t *rover = ffloors; rover; rover = rover->next)
-    {
-      if (!(rover->flags & FF_SOLID))
-	continue;
-
-      fixed_t h = *rover->topheight;
-      fixed_t l = *rover->bottomheight;
-
-      list<range_t>::iterator a, b, o, t;
-
-      // find range of openings [a,b) which this ffloor changes, starting from the lowest
-      for (a = Line_openings.begin(); l >= a->high && a != Line_openings.end(); a++)
-	; // a is the first affected one
-
-      for (b = a; h > b->low && b != Line_openings.end(); b++)
-	; // b is past-the-end
-
-      for (o = a; o != b; )
-	{
-	  if (l <= o->low)
-	    {
-	      // cut from below
-	      if (h >= o->high)
-		{
-		  // entire opening is closed
-		  t = o;
-		  o++ ;
-		  Line_openings.erase(t);
-		  continue; // skip o++ at end of block
-		}
-	      else
-		o->low = h; // raise bottom
-	    }
-	  else if (h >= o->high)
-	    {
-	      // cut from above
-	      o->high = l; // lower top
-	    }
-	  else
-	    {
-	      // floor splits the opening into two: [o->low, l] and [h, o->high]
-	      r.low = o->low;
-	      r.high = l;
-	      Line_openings.insert(o, r); // inserted just before o
-	      o->low = h;
-	    }
-
-	  o++;
-	}
-    }
-
-  return &Line_openings;
-}
-
-
-
 range_t sector_t::FindZRange(fixed_t z)
 {
   range_t r;
@@ -554,7 +493,7 @@ void line_opening_t::SubtractFromOpening(const Actor *a, sector_t *s)
 }
 
 
-static line_opening_t Opening;
+static thread_local line_opening_t Opening;
 
 /// Sets Opening to the window through a two sided line.
 line_opening_t *line_opening_t::Get(line_t *line, Actor *thing)
@@ -586,24 +525,23 @@ line_opening_t *line_opening_t::Get(line_t *line, Actor *thing)
   For each line in the given mapblock, call the passed \ref g_pit PIT function.
   If the function returns false, exit with false without checking anything else.
  
-  The validcount flags are used to avoid checking lines that are marked in multiple mapblocks,
-  so increment validcount before the first call to LinesIterator, then make one or more calls to it.
+  The visited marks in q are used to avoid checking lines that are marked in multiple mapblocks,
+  so call q.Begin() before the first call to LinesIterator, then make one or more calls to it.
 */
-bool blockmap_t::LinesIterator(int x, int y, line_iterator_t func)
+bool blockmap_t::LinesIterator(spatialquery_t &q, int x, int y, line_iterator_t func)
 {
   blockmapcell_t *cell = &cells[y*width + x];
 
   // first iterate through polyblockmap
   for (polyblock_t *p = cell->polys; p; p = p->next)
     {
-      if (p->polyobj && p->polyobj->validcount != validcount)
+      if (p->polyobj && q.VisitPolyobj(p->polyobj - parent_map->polyobjs))
 	{
 	  polyobj_t *temp = p->polyobj;
-	  temp->validcount = validcount;
 	  int n = temp->lines.size();
 	  for (int i=0; i < n; i++)
 	    {
-	      if (!func(temp->lines[i]))
+	      if (!func(q, temp->lines[i]))
 		return false;
 	    }
 	}
@@ -612,16 +550,77 @@ bool blockmap_t::LinesIterator(int x, int y, line_iterator_t func)
   line_t *lines = parent_map->lines;
 
   // iterate through the blocklist
-  for (Uint16 *p = cell->blocklist; *p != MAPBLOCK_END; p++) // index skips the initial zero marker
+  for (Uint32 *p = cell->blocklist; *p != MAPBLOCK_END; p++) // index skips the initial zero marker
     {
-      line_t *ld = &lines[*p];
-
-      if (ld->validcount == validcount)
+      if (!q.VisitLine(*p))
 	continue;   // line has already been checked
 
-      ld->validcount = validcount;
+      if (!func(q, &lines[*p]))
+	return false;
+    }
+  return true;        // everything was checked
+}
+
+
+/// \brief Iterate a blockmap cell for line_t's crossing a box
+/// \ingroup g_iterators
+/*!
+  Like LinesIterator, but only calls func for the lines which touch and cross the box b.
+  The blocklist lines are tested using the compact copies in bl, so the line_t's
+  that are rejected are never touched.
+*/
+bool blockmap_t::LinesBoxIterator(spatialquery_t &q, int x, int y, const bbox_t &b, line_iterator_t func)
+{
+  blockmapcell_t *cell = &cells[y*width + x];
+
+  // first iterate through polyblockmap
+  for (polyblock_t *p = cell->polys; p; p = p->next)
+    {
+      if (p->polyobj && q.VisitPolyobj(p->polyobj - parent_map->polyobjs))
+	{
+	  polyobj_t *temp = p->polyobj;
+	  int n = temp->lines.size();
+	  for (int i=0; i < n; i++)
+	    {
+	      line_t *ld = temp->lines[i];
+	      if (!b.BoxTouchBox(ld->bbox) || b.BoxOnLineSide(ld) != -1)
+		continue;
+
+	      if (!func(q, ld))
+		return false;
+	    }
+	}
+    }
+
+  line_t *lines = parent_map->lines;
+
+  // iterate through the blocklist
+  for (int i = cell->blocklist - lists; lists[i] != MAPBLOCK_END; i++)
+    {
+      line_t *ld;
+      if (bl.slopetype[i] == ST_MOVING)
+	{
+	  ld = &lines[lists[i]];
+	  if (!b.BoxTouchBox(ld->bbox) || b.BoxOnLineSide(ld) != -1)
+	    continue;
+	}
+      else
+	{
+	  // same tests as BoxTouchBox and BoxOnLineSide
+	  if (b[BOXRIGHT] <= bl.left[i] || b[BOXLEFT] >= bl.right[i] ||
+	      b[BOXTOP] <= bl.bottom[i] || b[BOXBOTTOM] >= bl.top[i])
+	    continue;
 
-      if (!func(ld))
+	  if (b.BoxOnLineSide(bl.x[i], bl.y[i], bl.dx[i], bl.dy[i], bl.slopetype[i]) != -1)
+	    continue;
+
+	  ld = &lines[lists[i]];
+	}
+
+      if (!q.VisitLine(lists[i]))
+	continue;   // line has already been checked
+
+      if (!func(q, ld))
 	return false;
     }
   return true;        // everything was checked
@@ -654,7 +653,7 @@ bool blockmap_t::ThingsIterator(int x, int y, thing_iterator_t func)
 */
 bool blockmap_t::RoughBlockSearch(Actor *center, int distance, thing_iterator_t func)
 {
-  extern Actor *blocksearch_self;
+  extern thread_local Actor *blocksearch_self;
   blocksearch_self = center; // for the iterators
 
   // searches from (x,y) outwards in increasing-radius mapblock squares
@@ -730,17 +729,21 @@ bool blockmap_t::RoughBlockSearch(Actor *center, int distance, thing_iterator_t
 
 /// \brief Iterate the Thinker list
 /*!
-  Iterates through all the Thinkers in the Map, calling 'func' for each.
+  Iterates through all the Thinkers in the Map (dormant ones included), calling 'func' for each.
   If the function returns false, exit with false without checking anything else.
 */
 bool Map::IterateThinkers(thinker_iterator_t func)
 {
   Thinker *t, *n;
-  for (t = thinkercap.next; t != &thinkercap; t = n)
+  for (int r = 0; r < 2; r++)
     {
-      n = t->next; // if t is removed while it thinks, its 'next' pointer will no longer be valid.
-      if (!func(t))
-	return false;
+      Thinker &cap = r ? dormantcap : thinkercap;
+      for (t = cap.next; t != &cap; t = n)
+	{
+	  n = t->next; // if t is removed while it thinks, its 'next' pointer will no longer be valid.
+	  if (!func(t))
+	    return false;
+	}
     }
   return true;
 }
@@ -748,18 +751,22 @@ bool Map::IterateThinkers(thinker_iterator_t func)
 
 /// \brief Iterate the Actors in the Thinker list
 /*!
-  Iterates through all the Actors in the Map, calling 'func' for each.
+  Iterates through all the Actors in the Map (dormant ones included), calling 'func' for each.
   If the function returns false, exit with false without checking anything else.
 */
 bool Map::IterateActors(thing_iterator_t func)
 {
   Thinker *t, *n;
-  for (t = thinkercap.next; t != &thinkercap; t = n)
+  for (int r = 0; r < 2; r++)
     {
-      n = t->next; // if t is removed while it thinks, its 'next' pointer will no longer be valid.
-      Actor *a = t->Inherits<Actor>();
-      if (a && !func(a))
-	return false;
+      Thinker &cap = r ? dormantcap : thinkercap;
+      for (t = cap.next; t != &cap; t = n)
+	{
+	  n = t->next; // if t is removed while it thinks, its 'next' pointer will no longer be valid.
+	  Actor *a = t->Inherits<Actor>();
+	  if (a && !func(a))
+	    return false;
+	}
     }
   return true;
 }
@@ -769,8 +776,51 @@ bool Map::IterateActors(thing_iterator_t func)
 //  Trace/intercept routines
 //==========================================================================
 
-trace_t trace;        ///< changed by Map::PathTraverse ONLY
-static bool earlyout;
+/// Every thread has a stack of query contexts, one per nesting level.
+/// A deque never moves its elements, so the borrowed references stay valid as it grows.
+static thread_local deque<spatialquery_t> query_stack;
+static thread_local unsigned query_depth = 0;
+
+
+query_scope_t::query_scope_t(Map *m)
+{
+  if (query_depth == query_stack.size())
+    query_stack.push_back(spatialquery_t());
+
+  q = &query_stack[query_depth++];
+  q->Begin(m);
+}
+
+
+query_scope_t::~query_scope_t()
+{
+  query_depth--;
+}
+
+
+void spatialquery_t::Begin(Map *m)
+{
+  mp = m;
+  trace.mp = m;
+
+  // the marks only need to be big enough, older stamps never match
+  if (linemarks.size() < unsigned(m->numlines))
+    linemarks.resize(m->numlines, 0);
+  if (sectormarks.size() < unsigned(m->numsectors))
+    sectormarks.resize(m->numsectors, 0);
+  if (polymarks.size() < unsigned(m->NumPolyobjs))
+    polymarks.resize(m->NumPolyobjs, 0);
+
+  if (++stamp == 0)
+    {
+      // wrapped around, forget all the old marks
+      linemarks.assign(linemarks.size(), 0);
+      sectormarks.assign(sectormarks.size(), 0);
+      polymarks.assign(polymarks.size(), 0);
+      stamp = 1;
+    }
+}
+
 
 /// \brief Find lines intercepted by the trace.
 /// \ingroup g_pit
@@ -780,8 +830,10 @@ static bool earlyout;
   A line is crossed if its endpoints are on opposite sides of the trace.
   Iteration is stopped if earlyout is true and a solid line is hit.
 */
-static bool PIT_AddLineIntercepts(line_t *ld)
+static bool PIT_AddLineIntercepts(spatialquery_t &q, line_t *ld)
 {
+  trace_t &trace = q.trace;
+
   int s1 = trace.dl.PointOnSide(ld->v1->x, ld->v1->y);
   int s2 = trace.dl.PointOnSide(ld->v2->x, ld->v2->y);
 
@@ -796,7 +848,7 @@ static bool PIT_AddLineIntercepts(line_t *ld)
     return true;    // behind source
 
   // try to early out the check
-  if (earlyout && frac < 1 && !ld->backsector)
+  if (q.earlyout && frac < 1 && !ld->backsector)
     {
       return false;   // stop checking
     }
@@ -817,7 +869,7 @@ static bool PIT_AddLineIntercepts(line_t *ld)
 /*!
   Checks if the Actor intercepts the given trace. If so, adds it to the intercepts list.
 */
-static bool PIT_AddThingIntercepts(Actor *thing)
+static bool PIT_AddThingIntercepts(trace_t &trace, Actor *thing)
 {
   fixed_t  x1, y1, x2, y2;
   bool tracepositive = (trace.delta.x.value() ^ trace.delta.y.value()) > 0;
@@ -866,54 +918,47 @@ static bool PIT_AddThingIntercepts(Actor *thing)
   return true;                // keep going
 }
 
+/// Sorts intercepts by distance along the trace, in place. Equally close ones keep their order.
+static void SortIntercepts(vector<intercept_t> &intercepts)
+{
+  // insertion sort, a trace seldom has more than a few dozen intercepts
+  int count = intercepts.size();
+  for (int i = 1; i < count; i++)
+    {
+      intercept_t in = intercepts[i];
+      int k = i;
+      for ( ; k > 0 && intercepts[k-1].frac > in.frac; k--)
+	intercepts[k] = intercepts[k-1];
+      intercepts[k] = in;
+    }
+}
+
+
 /// \brief Traverses the accumulated intercepts in order of closeness up to maxfrac.
 /// \ingroup g_trace
 /*!
   Calls the traverser function on all intercept_t's in the
   intercepts vector, in the nearness-of-intercept order.
+  The intercepts are sorted once instead of searching for the closest remaining one at every step.
+  The sort is stable and allocation free, so equally close intercepts are traversed in the order they were found,
+  just like the old selection did.
   \return true if the traverser function returns true for all lines
 */
-bool trace_t::TraverseIntercepts(traverser_t func, float maxfrac)
+bool spatialquery_t::TraverseIntercepts(traverser_t func, float maxfrac)
 {
-  int count = intercepts.size();
-  int i = count;
+  vector<intercept_t> &intercepts = trace.intercepts;
+  SortIntercepts(intercepts);
 
-  // TODO introsort
-  intercept_t *in = NULL;
-  while (i--)
+  int count = intercepts.size();
+  for (int i = 0; i < count; i++)
     {
-      float dist = fixed_t::FMAX;
-
-      for (int j = 0; j < count; j++)
-	{
-	  intercept_t *scan = &intercepts[j];
-	  if (scan->frac < dist)
-	    {
-	      dist = scan->frac;
-	      in = scan;
-	    }
-	}
-
-      if (dist > maxfrac)
+      intercept_t *in = &intercepts[i];
+      if (in->frac > maxfrac || in->frac >= fixed_t::FMAX)
 	return true;        // checked everything in range
 
-#if 0  // UNUSED
-      {
-        // don't check these yet, there may be others inserted
-        in = scan = intercepts;
-        for (scan = intercepts ; scan<intercept_p ; scan++)
-	  if (scan->frac > maxfrac)
-	    *in++ = *scan;
-        intercept_p = in;
-        return false;
-      }
-#endif
-
       // call the traverser function on the closest intercept_t
-      if (!func(in))
+      if (!func(*this, in))
 	return false; // don't bother going farther
-
-      in->frac = fixed_t::FMAX; // make sure this intercept is not chosen again
     }
 
   return true; // everything was traversed
@@ -952,15 +997,14 @@ void trace_t::Init(const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2)
   adding line/thing intercepts and then calling the traverser function for each intercept.
   \return true if the traverser function returns true for all lines
 */
-bool blockmap_t::PathTraverse(const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2, int flags, traverser_t trav)
+bool blockmap_t::PathTraverse(spatialquery_t &q, const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2, int flags, traverser_t trav)
 {
   // small HACK: make local copies so we can change them
   vec_t<fixed_t> p1(v1);
   vec_t<fixed_t> p2(v2);
 
-  earlyout = flags & PT_EARLYOUT;
-
-  validcount++;
+  q.Begin(parent_map);
+  q.earlyout = flags & PT_EARLYOUT;
 
 #define MAPBLOCKSIZE (MAPBLOCKUNITS * fixed_t::UNIT)
 
@@ -972,7 +1016,7 @@ bool blockmap_t::PathTraverse(const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2
     p1.y += 1; // don't side exactly on a line
 
   // set up the trace struct
-  trace.Init(p1, p2);
+  q.trace.Init(p1, p2);
 
   p1.x -= orgx;
   p1.y -= orgy;
@@ -1043,14 +1087,14 @@ bool blockmap_t::PathTraverse(const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2
 
       if (flags & PT_ADDLINES)
         {
-	  if (!LinesIterator(mapx, mapy, PIT_AddLineIntercepts))
+	  if (!LinesIterator(q, mapx, mapy, PIT_AddLineIntercepts))
 	    return false;   // early out
         }
 
       if (flags & PT_ADDTHINGS)
         {
-	  if (!ThingsIterator(mapx, mapy, PIT_AddThingIntercepts))
-	    return false;   // early out
+	  for (Actor *a = cells[mapy*width + mapx].actors; a; a = a->bnext)
+	    PIT_AddThingIntercepts(q.trace, a);
         }
 
       if (mapx == xt2 && mapy == yt2)
@@ -1069,7 +1113,73 @@ bool blockmap_t::PathTraverse(const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2
 
     }
   // go through the sorted list
-  return trace.TraverseIntercepts(trav, 1);
+  return q.TraverseIntercepts(trav, 1);
+}
+
+
+
+static bool PTR_BenchTrace(spatialquery_t &q, intercept_t *in)
+{
+  return true; // go through everything
+}
+
+/// A fixed random sequence of its own for benchmarks, so the game RNG is not disturbed.
+static inline float BenchRandom(Uint32 &seed)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) * (1.0f / (1 << 24));
+}
+
+
+/// Shoots long traces in random directions across the current map and times them.
+void Command_BenchTrace_f()
+{
+  if (!com_player || !com_player->mp)
+    {
+      CONS_Printf("You must be in a map.\n");
+      return;
+    }
+
+  Map *m = com_player->mp;
+  int n = COM.Argc() >= 2 ? atoi(COM.Argv(1)) : 10000;
+  if (n <= 0)
+    return;
+
+  // map extents
+  float x0 = fixed_t::FMAX, x1 = -x0, y0 = x0, y1 = -x0;
+  for (int i = 0; i < m->numvertexes; i++)
+    {
+      float x = m->vertexes[i].x.Float(), y = m->vertexes[i].y.Float();
+      x0 = min(x0, x); x1 = max(x1, x);
+      y0 = min(y0, y); y1 = max(y1, y);
+    }
+
+  Uint32 seed = 1;
+
+  const float range = 64 * MAPBLOCKUNITS; // as far as PathTraverse goes
+  unsigned total = 0, most = 0;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (int i = 0; i < n; i++)
+    {
+      float x = x0 + (x1 - x0) * BenchRandom(seed);
+      float y = y0 + (y1 - y0) * BenchRandom(seed);
+      float a = 2 * M_PI * BenchRandom(seed);
+
+      vec_t<fixed_t> v1(x, y, 0);
+      vec_t<fixed_t> v2(x + range * cos(a), y + range * sin(a), 0);
+
+      query_scope_t q(m);
+      m->blockmap->PathTraverse(*q, v1, v2, PT_ADDLINES|PT_ADDTHINGS, PTR_BenchTrace);
+
+      unsigned k = q->trace.intercepts.size();
+      total += k;
+      most = max(most, k);
+    }
+  double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+  CONS_Printf("%d traces in %.1f ms, %.2f us per trace\n", n, ms, ms * 1000 / n);
+  CONS_Printf("%.1f intercepts per trace on average, %u at most\n", float(total) / n, most);
 }
 
 
@@ -1099,7 +1209,7 @@ msecnode_t *msecnode_t::GetNode()
       headsecnode = headsecnode->m_snext;
     }
   else
-    node = (msecnode_t*)Z_Malloc(sizeof(*node), PU_LEVEL, NULL);
+    node = (msecnode_t*)Z_Malloc(sizeof(*node), PU_STATIC, NULL); // the freelist is shared by all maps
 
   return node;
 }
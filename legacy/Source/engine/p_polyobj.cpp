@@ -904,6 +904,18 @@ void Map::PO_Init()
 	}
     }
 
+  // the blockmap must not use its copies of the polyobj lines, since they move
+  vector<bool> moving(numlines, false);
+  for (int i = 0; i < NumPolyobjs; i++)
+    {
+      polyobj_t *p = &polyobjs[i];
+      int k = p->lines.size();
+      for (int j = 0; j < k; j++)
+	if (p->lines[j])
+	  moving[p->lines[j] - lines] = true;
+    }
+  blockmap->SetMovingLines(moving);
+
   // clean up for next level
   polyanchor.clear();
   polyspawn.clear();
@@ -621,7 +621,7 @@ float P_BulletSlope(PlayerPawn *p)
 //
 //added:16-02-98: used only for player (pistol,shotgun,chaingun)
 //                supershotgun use p_lineattack directely
-static float bulletsine;
+static thread_local float bulletsine;
 
 static void P_GunShot(PlayerPawn *p, bool accurate)
 {
@@ -0,0 +1,608 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Building REJECT tables for maps that come without a usable one.
+///
+/// Many PWADs ship an empty or zero-filled REJECT lump, which makes every failed sight check
+/// trace the BSP all the way to the target. For those maps a table is computed at load time.
+/// It is conservative: a sector pair is only rejected if no straight line can get from one
+/// to the other through two-sided lines, so CheckSight gives the same answers as before.
+/// With glVIS data the subsector PVS is collapsed into sectors, otherwise the sector portals
+/// are flooded, clipping each portal by the separating lines of the portals before it.
+/// The flood only holds if every sector is closed, since sight leaks through the gaps of an
+/// unclosed one, so maps with unclosed sectors and no glVIS data get no table.
+/// The table is built during the map load, in parallel, so every peer has it from the first tic.
+/// It is cached on disk keyed by the md5 of the map geometry.
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "doomdef.h"
+#include "doomdata.h"
+
+#include "g_map.h"
+#include "r_defs.h"
+#include "m_threads.h"
+#include "w_wad.h"
+#include "z_zone.h"
+#include "md5.h"
+
+using namespace std;
+
+
+static string rejectcache; ///< file storing the REJECT tables built so far
+
+/// Sets the file used for caching the built REJECT tables.
+void SetRejectCache(const char *filename)
+{
+  rejectcache = filename;
+}
+
+
+/// Changes whenever the builder changes, so old cached tables are not used.
+#define REJECT_BUILDER_VERSION 2
+
+/// The cache file is started over once it grows larger than this.
+#define REJECT_CACHE_MAXSIZE (32 << 20)
+
+/// Portal flood steps allowed per sector before settling for plain connectivity.
+#define REJECT_FLOOD_BUDGET 200000
+
+/// Tolerance of the portal clipping, in map units.
+static const double CLIP_EPSILON = 1.0/16;
+
+
+/// Cache file record header, followed by the table itself.
+struct rejectrecord_t
+{
+  char   magic[4]; ///< "RJCT"
+  byte   key[16];  ///< md5 of the map geometry
+  Uint32 numsectors;
+  Uint32 size;     ///< table size in bytes
+};
+
+
+/// A line segment, part of a portal.
+struct rseg_t
+{
+  double x1, y1, x2, y2;
+};
+
+
+/// A two-sided line between two (possibly identical) sectors.
+struct rportal_t
+{
+  rseg_t seg;
+  int    sec[2]; ///< front and back sector
+};
+
+
+/// \brief A REJECT table under construction.
+///
+/// The geometry is copied from the Map when the build is started, so the
+/// build never touches the Map itself (polyobjects move their vertices, for one).
+struct rejectbuild_t
+{
+  byte key[16];
+  int  numsectors;
+
+  vector<rportal_t>     portals;
+  vector< vector<int> > sectorportals; ///< portals of each sector
+
+  int          numsubsectors;
+  vector<int>  subsectorsector;        ///< sector of each subsector
+  vector<byte> pvs;                    ///< copy of the glVIS data, empty if not used
+
+  vector< vector<Uint32> > rows;       ///< bit b of rows[a] is set if sector b may be visible from sector a
+  vector<byte> table;                  ///< the finished REJECT table
+  int msecs;                           ///< build time
+
+  void Build();
+  void FloodPVS(int s);
+  void FloodPortals(int s);
+  void Connected(int s);
+};
+
+
+/// State of the portal flood from one sector.
+struct rflood_t
+{
+  rejectbuild_t  *b;
+  vector<Uint32> &row;
+  vector<byte>    onpath; ///< portals on the current path, a straight line crosses each one only once
+  int             budget;
+
+  rflood_t(rejectbuild_t *build, vector<Uint32> &r)
+    : b(build), row(r), onpath(build->portals.size(), 0), budget(REJECT_FLOOD_BUDGET) {}
+
+  void Through(int sec, int via, const rseg_t &src, const rseg_t &pass, bool first);
+};
+
+
+static inline void SetBit(vector<Uint32> &row, int n)
+{
+  row[n >> 5] |= 1u << (n & 31);
+}
+
+static inline bool GetBit(const vector<Uint32> &row, int n)
+{
+  return row[n >> 5] & (1u << (n & 31));
+}
+
+
+// Signed distance of (x, y) from the line through a and b, positive on the front (right) side.
+static inline double Dist(double ax, double ay, double dx, double dy, double len, double x, double y)
+{
+  return (dy*(x - ax) - dx*(y - ay)) / len;
+}
+
+
+// Clips t to the given side of the line from a to b, with some tolerance.
+// Returns false if nothing is left.
+static bool ClipSeg(rseg_t &t, double ax, double ay, double bx, double by, double side)
+{
+  double dx = bx - ax;
+  double dy = by - ay;
+  double len = sqrt(dx*dx + dy*dy);
+  if (len < CLIP_EPSILON)
+    return true; // degenerate line, do not clip
+
+  double d1 = side*Dist(ax, ay, dx, dy, len, t.x1, t.y1) + CLIP_EPSILON;
+  double d2 = side*Dist(ax, ay, dx, dy, len, t.x2, t.y2) + CLIP_EPSILON;
+
+  if (d1 < 0 && d2 < 0)
+    return false;
+  if (d1 >= 0 && d2 >= 0)
+    return true;
+
+  double f = d1 / (d1 - d2);
+  double x = t.x1 + f*(t.x2 - t.x1);
+  double y = t.y1 + f*(t.y2 - t.y1);
+  if (d1 < 0)
+    {
+      t.x1 = x;
+      t.y1 = y;
+    }
+  else
+    {
+      t.x2 = x;
+      t.y2 = y;
+    }
+  return true;
+}
+
+
+/*!
+  Clips t by the separating lines of the portals s and p.
+  A separating line goes through an endpoint of s and an endpoint of p so that
+  the other endpoints are on opposite sides of it. Any straight line crossing s and then p
+  stays on the side of p beyond p, and so must cross t there.
+*/
+static bool ClipSeparators(rseg_t &t, const rseg_t &s, const rseg_t &p)
+{
+  const double sx[2] = {s.x1, s.x2}, sy[2] = {s.y1, s.y2};
+  const double px[2] = {p.x1, p.x2}, py[2] = {p.y1, p.y2};
+
+  for (int i=0; i<2; i++)
+    for (int j=0; j<2; j++)
+      {
+	double dx = px[j] - sx[i];
+	double dy = py[j] - sy[i];
+	double len = sqrt(dx*dx + dy*dy);
+	if (len < CLIP_EPSILON)
+	  continue; // shared endpoint
+
+	double ds = Dist(sx[i], sy[i], dx, dy, len, sx[1-i], sy[1-i]);
+	double dp = Dist(sx[i], sy[i], dx, dy, len, px[1-j], py[1-j]);
+
+	double side;
+	if (ds < -CLIP_EPSILON && dp > CLIP_EPSILON)
+	  side = 1;
+	else if (ds > CLIP_EPSILON && dp < -CLIP_EPSILON)
+	  side = -1;
+	else
+	  continue; // not a separator
+
+	if (!ClipSeg(t, sx[i], sy[i], px[j], py[j], side))
+	  return false;
+      }
+
+  return true;
+}
+
+
+// Marks sec visible and continues into the portals of sec a line through src and pass can cross.
+// via is the portal through which sec was entered, pass is the part of it such a line can cross.
+void rflood_t::Through(int sec, int via, const rseg_t &src, const rseg_t &pass, bool first)
+{
+  SetBit(row, sec);
+
+  if (--budget < 0)
+    return;
+
+  // after crossing via, the line stays on the side of sec
+  const rportal_t &v = b->portals[via];
+  double side = 0;
+  if (v.sec[0] == sec && v.sec[1] != sec)
+    side = 1;
+  else if (v.sec[1] == sec && v.sec[0] != sec)
+    side = -1;
+
+  vector<int> &sp = b->sectorportals[sec];
+  for (unsigned i=0; i<sp.size() && budget >= 0; i++)
+    {
+      int n = sp[i];
+      if (onpath[n])
+	continue;
+
+      const rportal_t &p = b->portals[n];
+      rseg_t t = p.seg;
+      if (side && !ClipSeg(t, v.seg.x1, v.seg.y1, v.seg.x2, v.seg.y2, side))
+	continue;
+
+      if (!first && !ClipSeparators(t, src, pass))
+	continue;
+
+      int next = (p.sec[0] == sec) ? p.sec[1] : p.sec[0];
+      onpath[n] = 1;
+      Through(next, n, src, t, false);
+      onpath[n] = 0;
+    }
+}
+
+
+// Marks everything connected to sector s through portals, regardless of the line of sight.
+void rejectbuild_t::Connected(int s)
+{
+  vector<Uint32> &row = rows[s];
+  vector<int> stack(1, s);
+  SetBit(row, s);
+
+  while (!stack.empty())
+    {
+      int sec = stack.back();
+      stack.pop_back();
+
+      vector<int> &sp = sectorportals[sec];
+      for (unsigned i=0; i<sp.size(); i++)
+	{
+	  const rportal_t &p = portals[sp[i]];
+	  int next = (p.sec[0] == sec) ? p.sec[1] : p.sec[0];
+	  if (!GetBit(row, next))
+	    {
+	      SetBit(row, next);
+	      stack.push_back(next);
+	    }
+	}
+    }
+}
+
+
+// Fills rows[s] by flooding the portals of sector s.
+void rejectbuild_t::FloodPortals(int s)
+{
+  rflood_t f(this, rows[s]);
+  SetBit(f.row, s);
+
+  vector<int> &sp = sectorportals[s];
+  for (unsigned i=0; i<sp.size() && f.budget >= 0; i++)
+    {
+      int n = sp[i];
+      const rportal_t &p = portals[n];
+      int next = (p.sec[0] == s) ? p.sec[1] : p.sec[0];
+      f.onpath[n] = 1;
+      f.Through(next, n, p.seg, p.seg, true);
+      f.onpath[n] = 0;
+    }
+
+  if (f.budget < 0)
+    Connected(s); // too complex, give up on the line of sight
+}
+
+
+// Fills rows[s] from the glVIS PVS of the subsectors of sector s.
+void rejectbuild_t::FloodPVS(int s)
+{
+  vector<Uint32> &row = rows[s];
+  SetBit(row, s);
+
+  int rowbytes = (numsubsectors + 7) / 8;
+  for (int a=0; a<numsubsectors; a++)
+    {
+      if (subsectorsector[a] != s)
+	continue;
+
+      const byte *vis = &pvs[a * rowbytes];
+      for (int i=0; i<rowbytes; i++)
+	if (vis[i])
+	  for (int k=0; k<8; k++)
+	    if (vis[i] & (1 << k))
+	      {
+		int n = 8*i + k;
+		if (n < numsubsectors)
+		  SetBit(row, subsectorsector[n]);
+	      }
+    }
+}
+
+
+// Builds the table, using the WorkerPool.
+void rejectbuild_t::Build()
+{
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+
+  rows.resize(numsectors, vector<Uint32>((numsectors + 31) / 32, 0));
+
+  workers.ParallelFor(numsectors, [this](int s) {
+      if (!pvs.empty())
+	FloodPVS(s);
+      else
+	FloodPortals(s);
+    });
+
+  // sight is symmetric, so a pair is rejected only if neither side sees the other
+  table.assign((numsectors*numsectors + 7) / 8, 0);
+  for (int a=0; a<numsectors; a++)
+    for (int b=0; b<numsectors; b++)
+      if (!GetBit(rows[a], b) && !GetBit(rows[b], a))
+	{
+	  int n = a*numsectors + b;
+	  table[n >> 3] |= 1 << (n & 7);
+	}
+
+  rows.clear();
+  msecs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - t0).count();
+}
+
+
+/// Returns true if the lines of every sector form closed loops, i.e. at each vertex
+/// as many boundary lines of the sector arrive as leave, going around the sector.
+static bool SectorsClosed(Map *m)
+{
+  vector< vector<int> > seclines(m->numsectors);
+  for (int i=0; i<m->numlines; i++)
+    {
+      line_t *l = &m->lines[i];
+      if (l->frontsector)
+	seclines[l->frontsector - m->sectors].push_back(i);
+      if (l->backsector && l->backsector != l->frontsector)
+	seclines[l->backsector - m->sectors].push_back(i);
+    }
+
+  vector<int> balance(m->numvertexes, 0);
+  for (int s=0; s<m->numsectors; s++)
+    {
+      vector<int> &sl = seclines[s];
+      for (unsigned k=0; k<sl.size(); k++)
+	{
+	  line_t *l = &m->lines[sl[k]];
+	  int v1 = l->v1 - m->vertexes;
+	  int v2 = l->v2 - m->vertexes;
+	  // the front side goes from v1 to v2, the back side the other way
+	  int d = (l->frontsector == m->sectors + s ? 1 : 0) - (l->backsector == m->sectors + s ? 1 : 0);
+	  balance[v1] += d;
+	  balance[v2] -= d;
+	}
+
+      bool closed = true;
+      for (unsigned k=0; k<sl.size(); k++)
+	{
+	  line_t *l = &m->lines[sl[k]];
+	  if (balance[l->v1 - m->vertexes] || balance[l->v2 - m->vertexes])
+	    closed = false;
+	  balance[l->v1 - m->vertexes] = balance[l->v2 - m->vertexes] = 0;
+	}
+
+      if (!closed)
+	return false;
+    }
+
+  return true;
+}
+
+
+// Looks up a table from the cache file.
+static bool ReadRejectCache(const byte *key, int numsectors, byte *table, int size)
+{
+  if (rejectcache.empty())
+    return false;
+
+  FILE *f = fopen(rejectcache.c_str(), "rb");
+  if (!f)
+    return false;
+
+  bool found = false;
+  rejectrecord_t r;
+  while (fread(&r, sizeof(r), 1, f) == 1)
+    {
+      if (memcmp(r.magic, "RJCT", 4))
+	break; // garbage
+
+      if (!memcmp(r.key, key, 16) && int(r.numsectors) == numsectors && int(r.size) == size)
+	{
+	  found = fread(table, size, 1, f) == 1;
+	  break;
+	}
+
+      if (fseek(f, r.size, SEEK_CUR))
+	break;
+    }
+
+  fclose(f);
+  return found;
+}
+
+
+// Appends a table to the cache file.
+static void WriteRejectCache(const byte *key, int numsectors, const byte *table, int size)
+{
+  if (rejectcache.empty())
+    return;
+
+  // start over if the file has grown too large
+  const char *mode = "ab";
+  FILE *f = fopen(rejectcache.c_str(), "rb");
+  if (f)
+    {
+      fseek(f, 0, SEEK_END);
+      if (ftell(f) > REJECT_CACHE_MAXSIZE)
+	mode = "wb";
+      fclose(f);
+    }
+
+  f = fopen(rejectcache.c_str(), mode);
+  if (!f)
+    return;
+
+  rejectrecord_t r;
+  memcpy(r.magic, "RJCT", 4);
+  memcpy(r.key, key, 16);
+  r.numsectors = numsectors;
+  r.size = size;
+
+  bool ok = fwrite(&r, sizeof(r), 1, f) == 1;
+  ok = ok && fwrite(table, size, 1, f) == 1;
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok)
+    CONS_Printf("Could not write the REJECT cache '%s'.\n", rejectcache.c_str());
+}
+
+
+/*!
+  Loads the REJECT lump. If it is missing, too short or all zeros, a table is built instead.
+  If no table can be built, it rejects nothing, which is what the lump would have done.
+  vislump is the GL_PVS lump or -1, used for the hash only, the data itself is in glvis.
+*/
+void Map::LoadReject(int lump, int vislump)
+{
+  int size = (numsectors*numsectors + 7) / 8;
+  int length = fc.LumpLength(lump);
+
+  if (length >= size)
+    {
+      rejectmatrix = static_cast<byte*>(fc.CacheLumpNum(lump, PU_LEVEL));
+      for (int i=0; i<size; i++)
+	if (rejectmatrix[i])
+	  return; // a real one
+      CONS_Printf(" REJECT is zero-filled.\n");
+      Z_Free(rejectmatrix);
+    }
+  else
+    CONS_Printf(" REJECT is %s.\n", length ? "too short" : "empty");
+
+  rejectmatrix = static_cast<byte*>(Z_Malloc(size, PU_LEVEL, NULL));
+  memset(rejectmatrix, 0, size);
+
+  if (numsectors <= 1)
+    return;
+
+  rejectbuild_t *b = new rejectbuild_t;
+  b->numsectors = numsectors;
+
+  // only trust glVIS data of the right size
+  int rowbytes = (numsubsectors + 7) / 8;
+  if (glvis && vislump >= 0 && fc.LumpLength(vislump) >= rowbytes * numsubsectors)
+    {
+      b->numsubsectors = numsubsectors;
+      b->pvs.assign(glvis, glvis + rowbytes * numsubsectors);
+      b->subsectorsector.resize(numsubsectors);
+      for (int i=0; i<numsubsectors; i++)
+	b->subsectorsector[i] = subsectors[i].sector - sectors;
+    }
+  else
+    {
+      vislump = -1;
+      b->numsubsectors = 0;
+    }
+
+  // the table depends on the geometry and the builder only
+  md5_ctx ctx;
+  md5_init_ctx(&ctx);
+  int version = REJECT_BUILDER_VERSION;
+  md5_process_bytes(&version, sizeof(version), &ctx);
+  const int keylumps[] = {LUMP_VERTEXES, LUMP_LINEDEFS, LUMP_SIDEDEFS, LUMP_SECTORS};
+  for (int i=0; i<4; i++)
+    {
+      int l = lump - LUMP_REJECT + keylumps[i];
+      const void *data = fc.AcquireLump(l);
+      md5_process_bytes(data, fc.LumpLength(l), &ctx);
+      fc.ReleaseLump(l, data);
+    }
+  if (vislump >= 0)
+    {
+      md5_process_bytes(&b->pvs[0], b->pvs.size(), &ctx);
+      for (int i=0; i<numsubsectors; i++)
+	md5_process_bytes(&b->subsectorsector[i], sizeof(int), &ctx);
+    }
+  md5_finish_ctx(&ctx, b->key);
+
+  if (ReadRejectCache(b->key, numsectors, rejectmatrix, size))
+    {
+      CONS_Printf(" Using a cached REJECT table.\n");
+      delete b;
+      return;
+    }
+
+  if (b->pvs.empty())
+    {
+      if (!SectorsClosed(this))
+	{
+	  CONS_Printf(" Some sectors are not closed, no REJECT table built.\n");
+	  delete b;
+	  return;
+	}
+
+      b->sectorportals.resize(numsectors);
+      for (int i=0; i<numlines; i++)
+	{
+	  line_t *l = &lines[i];
+	  if (!(l->flags & ML_TWOSIDED) || !l->frontsector || !l->backsector)
+	    continue;
+
+	  rportal_t p;
+	  p.seg.x1 = l->v1->x.Float();
+	  p.seg.y1 = l->v1->y.Float();
+	  p.seg.x2 = l->v2->x.Float();
+	  p.seg.y2 = l->v2->y.Float();
+	  p.sec[0] = l->frontsector - sectors;
+	  p.sec[1] = l->backsector - sectors;
+
+	  int n = b->portals.size();
+	  b->portals.push_back(p);
+	  b->sectorportals[p.sec[0]].push_back(n);
+	  if (p.sec[1] != p.sec[0])
+	    b->sectorportals[p.sec[1]].push_back(n);
+	}
+    }
+
+  // Built right here, so the table is in place before the first tic on every peer.
+  b->Build();
+  memcpy(rejectmatrix, &b->table[0], size);
+  WriteRejectCache(b->key, numsectors, rejectmatrix, size);
+
+  if (devparm)
+    CONS_Printf("REJECT table built in %d ms (%s).\n", b->msecs, b->pvs.empty() ? "portals" : "glVIS");
+
+  delete b;
+}
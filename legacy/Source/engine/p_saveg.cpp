@@ -617,6 +617,7 @@ int DActor::Marshal(LArchive &a)
       if (diff & MD_MOVECOUNT) a << movecount;
       if (diff & MD_THRESHOLD) a << threshold;
       if (diff & MD_LASTLOOK)  a << lastlook;
+      if (eflags & MFE_DORMANT) a << sleeptic;
 
       if (diff & MD_SPECIAL1)  a << special1;
       if (diff & MD_SPECIAL2)  a << special2;
@@ -705,6 +706,7 @@ int DActor::Marshal(LArchive &a)
       if (diff & MD_MOVECOUNT) a << movecount;
       if (diff & MD_THRESHOLD) a << threshold;
       if (diff & MD_LASTLOOK)  a << lastlook;
+      if (eflags & MFE_DORMANT) a << sleeptic;
 
       if (diff & MD_SPECIAL1)  a << special1;
       if (diff & MD_SPECIAL2)  a << special2;
@@ -1007,6 +1009,7 @@ int Map::Serialize(LArchive &a)
   // TODO save map md5 checksum, to make sure the correct map is loaded
   a << starttic << maptic;
   a << kills << items << secrets; // conceivably scripts could change these
+  a << rndindex; // P_Random sequence of the Map when ticked in parallel
 
   //----------------------------------------------
   {
@@ -1269,27 +1272,39 @@ int Map::Serialize(LArchive &a)
   // Thinkers (including map objects aka Actors)
   a.Marker(MARK_THINK);
 
+  UnbatchThinkers(); // batches are not saved
+
   Thinker *th;
   // Now we use a one-pass recursive iteration of thinkers.
   //   Another possible way to do this:
   //   First do a recursive iteration of the thinkers, ONLY to create the pointer->id map.
   //   Then iterate the map serializing each element in turn (first writing the ID, of course).
 
+  // The dormant ring is stored after the thinker ring, in order, so that saving
+  // does not wake anyone up and loading restores both rings as they were.
+  int r;
   i = 0;
-  // only the stuff in the thinker ring is checked
-  for (th = thinkercap.next; th != &thinkercap; th = th->next)
+  for (r = 0; r < 2; r++)
     {
-      th->CheckPointers(); // clear pointers to deleted items
-      i++;
+      Thinker &cap = r ? dormantcap : thinkercap;
+      for (th = cap.next; th != &cap; th = th->next)
+	{
+	  th->CheckPointers(); // clear pointers to deleted items
+	  i++;
+	}
     }
 
-  a << i; // store the number of thinkers in ring
+  a << i; // store the number of thinkers in both rings
 
-  for (th = thinkercap.next; th != &thinkercap; th = th->next)
+  for (r = 0; r < 2; r++)
     {
-      Thinker::Serialize(th, a);
+      Thinker &cap = r ? dormantcap : thinkercap;
+      for (th = cap.next; th != &cap; th = th->next)
+	Thinker::Serialize(th, a);
     }
 
+  BatchThinkers();
+
   a.Marker(MARK_MISC);
   //----------------------------------------------
   // respawnqueue
@@ -1350,6 +1365,7 @@ int Map::Unserialize(LArchive &a)
 
   a << starttic << maptic;
   a << kills << items << secrets;
+  a << rndindex;
 
   line_t *li;
   side_t *si;
@@ -1531,8 +1547,19 @@ int Map::Unserialize(LArchive &a)
     {
       Thinker *th = Thinker::Unserialize(a);
       AddThinker(th);
+
+      // dormant DActors go back to the dormant ring, which was saved after the thinker ring
+      DActor *d = th->Inherits<DActor>();
+      if (d && (d->eflags & MFE_DORMANT))
+	{
+	  Uint32 tic = d->sleeptic;
+	  SleepActor(d);
+	  d->sleeptic = tic;
+	}
     }
 
+  BatchThinkers();
+
   if (!a.Marker(MARK_MISC))
     return -5;
   //----------------------------------------------
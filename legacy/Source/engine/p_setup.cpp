@@ -25,7 +25,11 @@
 /// spawns static Thinkers and the initial Actors.
 
 #include <math.h>
+#include <stdio.h>
 #include <string.h>
+#include <chrono>
+#include <string>
+#include <vector>
 
 #include "doomdef.h"
 #include "doomdata.h"
@@ -50,6 +54,7 @@
 #include "m_bbox.h"
 #include "m_swap.h"
 #include "m_misc.h"
+#include "m_random.h"
 #include "m_argv.h"
 #include "tables.h"
 
@@ -63,6 +68,9 @@
 #include "s_sound.h"
 #include "w_wad.h"
 #include "z_zone.h"
+#include "m_profile.h"
+#include "m_threads.h"
+#include "md5.h"
 #include "r_splats.h"
 
 #include "t_parse.h"
@@ -114,10 +122,10 @@ void Map::LoadVertexes(int lump)
   // Allocate zone memory for buffer.
   vertexes = (vertex_t*)Z_Malloc(numvertexes*sizeof(vertex_t), PU_LEVEL, 0);
 
-  // Load data into cache.
-  byte *data = (byte *)fc.CacheLumpNum(lump, PU_STATIC);
+  // Read-only access to the lump, zero-copy if the wad is memory mapped.
+  const void *data = fc.AcquireLump(lump);
 
-  mapvertex_t *mv = (mapvertex_t *)data;
+  const mapvertex_t *mv = static_cast<const mapvertex_t*>(data);
   vertex_t *v = vertexes;
   root_bbox.Clear(); // we also build the root bounding box here
 
@@ -130,8 +138,7 @@ void Map::LoadVertexes(int lump)
       root_bbox.Add(v->x, v->y);
     }
 
-  // Free buffer memory.
-  Z_Free(data);
+  fc.ReleaseLump(lump, data);
 }
 
 
@@ -141,9 +148,9 @@ void Map::LoadSegs(int lump)
   numsegs = fc.LumpLength(lump) / sizeof(mapseg_t);
   segs = (seg_t *)Z_Malloc(numsegs*sizeof(seg_t), PU_LEVEL, NULL);
   memset(segs, 0, numsegs*sizeof(seg_t)); // clear everything
-  byte *data = (byte *)fc.CacheLumpNum(lump, PU_STATIC);
+  const void *data = fc.AcquireLump(lump);
 
-  mapseg_t *ms = (mapseg_t *)data;
+  const mapseg_t *ms = static_cast<const mapseg_t*>(data);
   seg_t    *seg = segs;
   for (int i = 0; i < numsegs; i++, seg++, ms++)
     {
@@ -163,7 +170,7 @@ void Map::LoadSegs(int lump)
       seg->backsector = (ldef->flags & ML_TWOSIDED) ? ldef->sideptr[seg->side^1]->sector : NULL;
     }
 
-  Z_Free(data);
+  fc.ReleaseLump(lump, data);
 }
 
 
@@ -173,9 +180,9 @@ void Map::LoadSubsectors(int lump)
   numsubsectors = fc.LumpLength(lump) / sizeof(mapsubsector_t);
   subsectors = (subsector_t *)Z_Malloc(numsubsectors * sizeof(subsector_t), PU_LEVEL, 0);
   memset(subsectors, 0, numsubsectors * sizeof(subsector_t));
-  byte *data = (byte *)fc.CacheLumpNum(lump, PU_STATIC);
+  const void *data = fc.AcquireLump(lump);
 
-  mapsubsector_t *mss = (mapsubsector_t *)data;
+  const mapsubsector_t *mss = static_cast<const mapsubsector_t*>(data);
   subsector_t *ss = subsectors;
 
   for (int i=0; i<numsubsectors; i++, ss++, mss++)
@@ -184,7 +191,7 @@ void Map::LoadSubsectors(int lump)
       ss->first_seg = SHORT(mss->firstseg);
     }
 
-  Z_Free(data);
+  fc.ReleaseLump(lump, data);
 }
 
 
@@ -280,9 +287,9 @@ void Map::LoadNodes(int lump)
 {
   numnodes = fc.LumpLength(lump) / sizeof(mapnode_t);
   nodes = (node_t *)Z_Malloc(numnodes*sizeof(node_t),PU_LEVEL,0);
-  byte *data = (byte*)fc.CacheLumpNum(lump,PU_STATIC);
+  const void *data = fc.AcquireLump(lump);
 
-  mapnode_t *mn = (mapnode_t *)data;
+  const mapnode_t *mn = static_cast<const mapnode_t*>(data);
   node_t *no = nodes;
 
   for (int i=0 ; i<numnodes ; i++, no++, mn++)
@@ -300,7 +307,7 @@ void Map::LoadNodes(int lump)
         }
     }
 
-  Z_Free(data);
+  fc.ReleaseLump(lump, data);
 }
 
 
@@ -845,13 +852,16 @@ blockmap_t::~blockmap_t()
 {
   Z_Free(cells);
   Z_Free(lists);
+  if (bl_data)
+    Z_Free(bl_data);
 }
 
-// Load a blockmap from a lump.
-blockmap_t::blockmap_t(int lump)
+// Load a blockmap from a lump. The map has numlines lines.
+blockmap_t::blockmap_t(int lump, int numlines)
 {
   lists = NULL;
   cells = NULL;
+  bl_data = NULL;
 
   int size = fc.LumpLength(lump)/2;
 
@@ -875,7 +885,7 @@ blockmap_t::blockmap_t(int lump)
   // check the blockmap for errors
   int errors = 0;
   int first = 4 + numcells; // first possible blocklist offset (in shorts)
-  int list_size = size - first; // blocklist size
+  list_size = size - first; // blocklist size
 
   if (list_size < 2) // one empty blocklist (two shorts) is the minimal size
     {
@@ -884,8 +894,19 @@ blockmap_t::blockmap_t(int lump)
       throw -1;
     }
 
-  lists = static_cast<Uint16 *>(Z_Malloc(list_size * sizeof(Uint16), PU_LEVEL, 0));
-  memcpy(lists, &blockmap_lump[first], 2*list_size); // copy the lists
+  // widen the lists to 32 bits
+  lists = static_cast<Uint32 *>(Z_Malloc(list_size * sizeof(Uint32), PU_LEVEL, 0));
+  for (int i=0; i < list_size; i++)
+    {
+      Uint16 temp = blockmap_lump[first + i];
+      lists[i] = (temp == 0xFFFF) ? MAPBLOCK_END : temp;
+
+      if (temp != 0xFFFF && temp >= numlines && errors < 50)
+	{
+	  CONS_Printf(" Blocklist entry %d refers to a nonexistent line %d.\n", i, temp);
+	  errors++;
+	}
+    }
 
   // Build a new blockmap index using pointers
   cells = static_cast<blockmapcell_t *>(Z_Malloc(numcells * sizeof(blockmapcell_t), PU_LEVEL, 0));
@@ -942,6 +963,127 @@ blockmap_t::blockmap_t(int lump)
 }
 
 
+static string blockmapcache; ///< file storing the blockmaps generated so far
+
+/// Sets the file used for caching the generated blockmaps.
+void SetBlockmapCache(const char *filename)
+{
+  blockmapcache = filename;
+}
+
+
+/// Changes whenever the generator changes, so old cached blockmaps are not used.
+#define BLOCKMAP_GENERATOR_VERSION 1
+
+/// The cache file is started over once it grows larger than this.
+#define BLOCKMAP_CACHE_MAXSIZE (64 << 20)
+
+
+/// Cache file record header, followed by the blocklist offset of each cell and the blocklists.
+struct blockmaprecord_t
+{
+  char   magic[4]; ///< "BMAP"
+  byte   key[16];  ///< md5 of the line geometry
+  Sint32 width, height;
+  Uint32 list_size;
+};
+
+
+/// A line stored in a cell, binned by the generator.
+struct cellentry_t
+{
+  int cell;
+  int line;
+};
+
+
+// Finds the cells line li goes through, in order from v1 to v2.
+static void RasterizeLine(const line_t *li, fixed_t orgx, fixed_t orgy, int width, vector<int> &cellnums)
+{
+  double x1 = (li->v1->x - orgx).Float() / MAPBLOCKUNITS;
+  double y1 = (li->v1->y - orgy).Float() / MAPBLOCKUNITS;
+  double x2 = (li->v2->x - orgx).Float() / MAPBLOCKUNITS;
+  double y2 = (li->v2->y - orgy).Float() / MAPBLOCKUNITS;
+
+  double dx = x2-x1;
+  double dy = y2-y1;
+
+  double x_intercept = x1, y_intercept = y1;
+
+  // split (nonnegative) block coords to integer and fractional parts
+  double dummy;
+  int bx1 = int(x1); x1 = modf(x1, &dummy);
+  int by1 = int(y1); y1 = modf(y1, &dummy);
+  int bx2 = int(x2); x2 = modf(x2, &dummy);
+  int by2 = int(y2); y2 = modf(y2, &dummy);
+
+  int bdx, bdy;
+  double xstep, ystep;
+
+  if (bx2 > bx1)
+    {
+      bdx = 1;
+      ystep = dy / fabs(dx);
+      y_intercept += (1 - x1) * ystep;
+    }
+  else if (bx2 < bx1)
+    {
+      bdx = -1;
+      ystep = dy / fabs(dx);
+      y_intercept += x1 * ystep;
+    }
+  else
+    {
+      // vertical run of blocks
+      bdx = 0;
+      ystep = 0;
+      y_intercept += 1000000; // must not hit it ever
+    }
+
+  if (by2 > by1)
+    {
+      bdy = 1;
+      xstep = dx / fabs(dy);
+      x_intercept += (1 - y1) * xstep;
+    }
+  else if (by2 < by1)
+    {
+      bdy = -1;
+      xstep = dx / fabs(dy);
+      x_intercept += y1 * xstep;
+    }
+  else
+    {
+      // horizontal run of blocks
+      bdy = 0;
+      xstep = 0;
+      x_intercept += 1000000;
+    }
+
+  // Step through map blocks.
+  // Count is present to prevent a round off error causing us to miss the end block.
+  for (int count = abs(bx2-bx1) + abs(by2-by1); ; count--)
+    {
+      cellnums.push_back(by1*width + bx1);
+
+      if (count <= 0)
+	break;
+
+      // intercepts can not become negative until count has expired
+      if (int(y_intercept) == by1)
+	{
+	  y_intercept += ystep;
+	  bx1 += bdx;
+	}
+      else if (int(x_intercept) == bx1)
+	{
+	  x_intercept += xstep;
+	  by1 += bdy;
+	}
+    }
+}
+
+
 // Build a new blockmap
 blockmap_t::blockmap_t(Map *mp)
 {
@@ -952,136 +1094,306 @@ blockmap_t::blockmap_t(Map *mp)
   width = BlockX(mp->root_bbox[BOXRIGHT]) + 1;
   height = BlockY(mp->root_bbox[BOXTOP]) + 1;
 
-  int numcells = width * height;
-  CONS_Printf("Generating blockmap (%dx%d blocks)...", width, height);
+  bl_data = NULL;
 
-  vector<Uint16> xxx[numcells];
+  chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
 
+  // the blockmap depends on the line geometry and the generator only
+  byte key[16];
+  md5_ctx ctx;
+  md5_init_ctx(&ctx);
+  int version = BLOCKMAP_GENERATOR_VERSION;
+  md5_process_bytes(&version, sizeof(version), &ctx);
   for (int i=0; i < mp->numlines; i++)
     {
       line_t *li = &mp->lines[i];
-      double x1 = (li->v1->x - orgx).Float() / MAPBLOCKUNITS;
-      double y1 = (li->v1->y - orgy).Float() / MAPBLOCKUNITS;
-      double x2 = (li->v2->x - orgx).Float() / MAPBLOCKUNITS;
-      double y2 = (li->v2->y - orgy).Float() / MAPBLOCKUNITS;
+      Sint32 v[4] = {Sint32(li->v1->x.value()), Sint32(li->v1->y.value()), Sint32(li->v2->x.value()), Sint32(li->v2->y.value())};
+      md5_process_bytes(v, sizeof(v), &ctx);
+    }
+  Sint32 org[2] = {Sint32(orgx.value()), Sint32(orgy.value())};
+  md5_process_bytes(org, sizeof(org), &ctx);
+  md5_finish_ctx(&ctx, key);
 
-      double dx = x2-x1;
-      double dy = y2-y1;
+  if (ReadCache(key))
+    {
+      int msecs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - t0).count();
+      CONS_Printf("Using a cached blockmap (%dx%d blocks, %d ms).\n", width, height, msecs);
+      return;
+    }
 
-      double x_intercept = x1, y_intercept = y1;
+  CONS_Printf("Generating blockmap (%dx%d blocks)...", width, height);
+  Generate();
+  WriteCache(key);
 
-      // split (nonnegative) block coords to integer and fractional parts
-      double dummy;
-      int bx1 = int(x1); x1 = modf(x1, &dummy);
-      int by1 = int(y1); y1 = modf(y1, &dummy);
-      int bx2 = int(x2); x2 = modf(x2, &dummy);
-      int by2 = int(y2); y2 = modf(y2, &dummy);
+  int msecs = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - t0).count();
+  CONS_Printf("done in %d ms. %d entries, %d bytes.\n", msecs, list_size, int(4*list_size + width*height*sizeof(blockmapcell_t)));
+}
 
-      int bdx, bdy;
-      double xstep, ystep;
 
-      if (bx2 > bx1)
-	{
-	  bdx = 1;
-	  ystep = dy / fabs(dx);
-	  y_intercept += (1 - x1) * ystep;
-	}
-      else if (bx2 < bx1)
+/*!
+  The lines are split into consecutive chunks, and each chunk is rasterized by the WorkerPool
+  into bins that each cover a range of cells. Then the bins of each cell range are merged
+  chunk by chunk, so every blocklist lists its lines in increasing order, just as a
+  single pass over the lines would.
+*/
+void blockmap_t::Generate()
+{
+  PROFILE_ZONE("GenerateBlockMap");
+
+  const Map *mp = parent_map;
+  int numlines = mp->numlines;
+  int numcells = width * height;
+
+  int nchunks = (workers.NumThreads() + 1) * 4;
+  int bandsize = (numcells + nchunks - 1) / nchunks; // cells per bin
+  int nbands = (numcells + bandsize - 1) / bandsize;
+
+  // bins[chunk][band] holds the lines of the chunk crossing the cells of the band, in line order
+  vector< vector< vector<cellentry_t> > > bins(nchunks, vector< vector<cellentry_t> >(nbands));
+
+  workers.ParallelFor(nchunks, [&](int c) {
+      int begin = (long long)numlines * c / nchunks;
+      int end = (long long)numlines * (c+1) / nchunks;
+      vector<int> cellnums;
+      for (int i = begin; i < end; i++)
 	{
-	  bdx = -1;
-	  ystep = dy / fabs(dx);
-	  y_intercept += x1 * ystep;
+	  cellnums.clear();
+	  RasterizeLine(&mp->lines[i], orgx, orgy, width, cellnums);
+	  for (unsigned k = 0; k < cellnums.size(); k++)
+	    {
+	      int n = cellnums[k];
+	      if (n < 0 || n >= numcells)
+		continue; // cannot happen with a valid root_bbox
+	      cellentry_t e = {n, i};
+	      bins[c][n / bandsize].push_back(e);
+	    }
 	}
-      else
+    });
+
+  // count the lines in each cell, and the blocklist entries needed by each band
+  vector< vector<int> > counts(nbands);
+  vector<int> bandsizes(nbands);
+
+  workers.ParallelFor(nbands, [&](int b) {
+      int first = b * bandsize;
+      counts[b].assign(min(bandsize, numcells - first), 0);
+      for (int c = 0; c < nchunks; c++)
 	{
-	  // vertical run of blocks
-	  bdx = 0;
-	  ystep = 0;
-	  y_intercept += 1000000; // must not hit it ever
+	  vector<cellentry_t> &bin = bins[c][b];
+	  for (unsigned k = 0; k < bin.size(); k++)
+	    counts[b][bin[k].cell - first]++;
 	}
 
-      if (by2 > by1)
+      int n = 0;
+      for (unsigned k = 0; k < counts[b].size(); k++)
+	if (counts[b][k])
+	  n += counts[b][k] + 1; // line numbers + end marker
+      bandsizes[b] = n;
+    });
+
+  // the bands are stored one after another, following the "empty block" list
+  vector<int> bandstart(nbands);
+  list_size = 1;
+  for (int b = 0; b < nbands; b++)
+    {
+      bandstart[b] = list_size;
+      list_size += bandsizes[b];
+    }
+
+  lists = static_cast<Uint32 *>(Z_Malloc(list_size * sizeof(Uint32), PU_LEVEL, 0));
+  lists[0] = MAPBLOCK_END; // "empty block" list
+
+  cells = static_cast<blockmapcell_t *>(Z_Malloc(numcells * sizeof(blockmapcell_t), PU_LEVEL, 0));
+  memset(cells, 0, numcells * sizeof(blockmapcell_t));
+
+  workers.ParallelFor(nbands, [&](int b) {
+      int first = b * bandsize;
+      vector<int> &next = counts[b]; // becomes the next free slot of each cell
+      int idx = bandstart[b];
+      for (unsigned k = 0; k < next.size(); k++)
 	{
-	  bdy = 1;
-	  xstep = dx / fabs(dy);
-	  x_intercept += (1 - y1) * xstep;
+	  int n = next[k];
+	  if (!n)
+	    {
+	      cells[first + k].blocklist = &lists[0];
+	      continue;
+	    }
+
+	  cells[first + k].blocklist = &lists[idx];
+	  next[k] = idx;
+	  idx += n;
+	  lists[idx++] = MAPBLOCK_END;
 	}
-      else if (by2 < by1)
+
+      for (int c = 0; c < nchunks; c++)
 	{
-	  bdy = -1;
-	  xstep = dx / fabs(dy);
-	  x_intercept += y1 * xstep;
+	  vector<cellentry_t> &bin = bins[c][b];
+	  for (unsigned k = 0; k < bin.size(); k++)
+	    lists[next[bin[k].cell - first]++] = bin[k].line;
 	}
-      else
+    });
+}
+
+
+// Checks that the cached blocklists only hold lines of the map, and that every cell list is terminated.
+static bool ValidBlocklists(const vector<Uint32> &offsets, const vector<Uint32> &lists, Uint32 numlines)
+{
+  Uint32 n = lists.size();
+  if (lists[n-1] != MAPBLOCK_END)
+    return false; // so every list is terminated before n
+
+  for (Uint32 i=0; i < n; i++)
+    if (lists[i] != MAPBLOCK_END && lists[i] >= numlines)
+      return false;
+
+  for (unsigned i=0; i < offsets.size(); i++)
+    if (offsets[i] >= n)
+      return false;
+
+  return true;
+}
+
+
+/*!
+  Looks up the blockmap from the cache file.
+  Records that do not pass the checks are skipped, since a later record may replace a bad one.
+*/
+bool blockmap_t::ReadCache(const byte *key)
+{
+  if (blockmapcache.empty())
+    return false;
+
+  FILE *f = fopen(blockmapcache.c_str(), "rb");
+  if (!f)
+    return false;
+
+  int numcells = width * height;
+  bool found = false;
+  blockmaprecord_t r;
+  while (!found && fread(&r, sizeof(r), 1, f) == 1)
+    {
+      if (memcmp(r.magic, "BMAP", 4) || r.width < 0 || r.height < 0)
+	break; // garbage
+
+      if (memcmp(r.key, key, 16) || r.width != width || r.height != height || r.list_size < 1)
 	{
-	  // horizontal run of blocks
-	  bdy = 0;
-	  xstep = 0;
-	  x_intercept += 1000000;
+	  if (fseek(f, (long(r.width) * r.height + r.list_size) * sizeof(Uint32), SEEK_CUR))
+	    break;
+	  continue;
 	}
 
-      // Step through map blocks.
-      // Count is present to prevent a round off error causing us to miss the end block.
-      for (int count = abs(bx2-bx1) + abs(by2-by1); ; count--)
-	{
-	  // store the line number
-	  xxx[by1*width + bx1].push_back(i);
+      vector<Uint32> offsets(numcells);
+      vector<Uint32> temp(r.list_size);
+      if (fread(&offsets[0], sizeof(Uint32), numcells, f) != unsigned(numcells) ||
+	  fread(&temp[0], sizeof(Uint32), r.list_size, f) != r.list_size)
+	break; // truncated
 
-	  if (count <= 0)
-	    break;
+      if (!ValidBlocklists(offsets, temp, parent_map->numlines))
+	continue;
 
-	  // intercepts can not become negative until count has expired
-	  if (int(y_intercept) == by1)
-	    {
-	      y_intercept += ystep;
-	      bx1 += bdx;
-	    }
-	  else if (int(x_intercept) == bx1)
-	    {
-	      x_intercept += xstep;
-	      by1 += bdy;
-	    }
-	}
-    }
+      list_size = r.list_size;
+      lists = static_cast<Uint32 *>(Z_Malloc(list_size * sizeof(Uint32), PU_LEVEL, 0));
+      memcpy(lists, &temp[0], list_size * sizeof(Uint32));
 
-  // convert the vector array into old-style blocklists (no packing for now...)
+      cells = static_cast<blockmapcell_t *>(Z_Malloc(numcells * sizeof(blockmapcell_t), PU_LEVEL, 0));
+      memset(cells, 0, numcells * sizeof(blockmapcell_t));
+      for (int i=0; i < numcells; i++)
+	cells[i].blocklist = &lists[offsets[i]];
 
-  // find out blocklist size
-  int list_size = 1; // "empty block" list (only end marker)
-  for (int i=0; i<numcells; i++)
-    {
-      int temp = xxx[i].size();
-      if (temp)
-	list_size += temp + 1; // line numbers + end marker
+      found = true;
     }
 
-  lists = static_cast<Uint16 *>(Z_Malloc(list_size * sizeof(Uint16), PU_LEVEL, 0));
+  fclose(f);
+  return found;
+}
 
-  // Build a new blockmap index using pointers
-  cells = static_cast<blockmapcell_t *>(Z_Malloc(numcells * sizeof(blockmapcell_t), PU_LEVEL, 0));
-  memset(cells, 0, numcells * sizeof(blockmapcell_t));
 
-  int idx = 0; // next free slot
-  lists[idx++] = MAPBLOCK_END; // "empty block" list
-  for (int i=0; i<numcells; i++)
+// Appends the blockmap to the cache file.
+void blockmap_t::WriteCache(const byte *key) const
+{
+  if (blockmapcache.empty())
+    return;
+
+  // start over if the file has grown too large
+  const char *mode = "ab";
+  FILE *f = fopen(blockmapcache.c_str(), "rb");
+  if (f)
     {
-      int temp = xxx[i].size();
-      if (!temp)
-	cells[i].blocklist = &lists[0];
-      else
-	{
-	  // add a new blocklist
-	  cells[i].blocklist = &lists[idx];
-	  for (int k=0; k<temp; k++)
-	    lists[idx++] = xxx[i][k];
-	  lists[idx++] = MAPBLOCK_END;
-	}
+      fseek(f, 0, SEEK_END);
+      if (ftell(f) > BLOCKMAP_CACHE_MAXSIZE)
+	mode = "wb";
+      fclose(f);
     }
 
-  if (idx != list_size)
-    I_Error("FUCK!\n");
+  f = fopen(blockmapcache.c_str(), mode);
+  if (!f)
+    return;
 
-  CONS_Printf("done. %d entries, %d bytes.\n", list_size, 2*(4 + numcells + list_size));
+  int numcells = width * height;
+  vector<Uint32> offsets(numcells);
+  for (int i=0; i < numcells; i++)
+    offsets[i] = cells[i].blocklist - lists;
+
+  blockmaprecord_t r;
+  memcpy(r.magic, "BMAP", 4);
+  memcpy(r.key, key, 16);
+  r.width = width;
+  r.height = height;
+  r.list_size = list_size;
+
+  bool ok = fwrite(&r, sizeof(r), 1, f) == 1;
+  ok = ok && fwrite(&offsets[0], sizeof(Uint32), numcells, f) == unsigned(numcells);
+  ok = ok && fwrite(lists, sizeof(Uint32), list_size, f) == unsigned(list_size);
+  ok = (fclose(f) == 0) && ok;
+
+  if (!ok)
+    CONS_Printf("Could not write the blockmap cache '%s'.\n", blockmapcache.c_str());
+}
+
+void blockmap_t::BuildLineData()
+{
+  // one allocation for all the arrays
+  int n = list_size;
+  bl_data = Z_Malloc(n * (8*sizeof(fixed_t) + sizeof(byte)), PU_LEVEL, 0);
+
+  fixed_t *f = static_cast<fixed_t *>(bl_data);
+  bl.left   = f;  f += n;
+  bl.right  = f;  f += n;
+  bl.bottom = f;  f += n;
+  bl.top    = f;  f += n;
+  bl.x      = f;  f += n;
+  bl.y      = f;  f += n;
+  bl.dx     = f;  f += n;
+  bl.dy     = f;  f += n;
+  bl.slopetype = reinterpret_cast<byte *>(f);
+
+  // Only the entries the cells point to are filled, the lump may have unused ones in between.
+  line_t *lines = parent_map->lines;
+  vector<bool> done(n, false);
+  int numcells = width * height;
+  for (int c=0; c < numcells; c++)
+    for (int i = cells[c].blocklist - lists; lists[i] != MAPBLOCK_END && !done[i]; i++)
+      {
+	done[i] = true;
+	line_t *ld = &lines[lists[i]];
+	bl.left[i]   = ld->bbox[BOXLEFT];
+	bl.right[i]  = ld->bbox[BOXRIGHT];
+	bl.bottom[i] = ld->bbox[BOXBOTTOM];
+	bl.top[i]    = ld->bbox[BOXTOP];
+	bl.x[i]  = ld->v1->x;
+	bl.y[i]  = ld->v1->y;
+	bl.dx[i] = ld->dx;
+	bl.dy[i] = ld->dy;
+	bl.slopetype[i] = ld->slopetype;
+      }
+}
+
+
+void blockmap_t::SetMovingLines(const vector<bool> &moving)
+{
+  for (int i=0; i < list_size; i++)
+    if (lists[i] != MAPBLOCK_END && moving[lists[i]])
+      bl.slopetype[i] = ST_MOVING;
 }
 
 
@@ -1091,6 +1403,7 @@ void Map::LoadBlockMap(int lump)
   int size = fc.LumpLength(lump)/2;
 
   if (M_CheckParm("-blockmap") ||
+      numlines >= 0xFFFF || // line numbers do not fit in the lump format
       size < 6 || // smallest possible blockmap
       size > 0x10000+1) // largest, always fully addressable blockmap
     blockmap = new blockmap_t(this); // blockmap lump is invalid, we must build our own
@@ -1099,7 +1412,7 @@ void Map::LoadBlockMap(int lump)
       // use the blockmap from the wad
       try
 	{
-	  blockmap = new blockmap_t(lump);
+	  blockmap = new blockmap_t(lump, numlines);
 	  blockmap->parent_map = this;
 	}
       catch(int i)
@@ -1108,6 +1421,8 @@ void Map::LoadBlockMap(int lump)
 	  blockmap = new blockmap_t(this); // blockmap lump is invalid, we must build our own
 	}
     }
+
+  blockmap->BuildLineData();
 }
 
 
@@ -1583,6 +1898,8 @@ void Map::SetupSky()
 //
 bool Map::Setup(tic_t start, bool spawnthings)
 {
+  PROFILE_ZONE("Map::Setup");
+
   extern  bool precache;
 
   CONS_Printf("Loading map %s...\n", lumpname.c_str());
@@ -1592,6 +1909,7 @@ bool Map::Setup(tic_t start, bool spawnthings)
   maptic = 0;
   starttic = start;
   kills = items = secrets = 0;
+  rndindex = P_GetRandIndex();
 
   // internal game map
   lumpnum = fc.GetNumForName(lumpname.c_str());
@@ -1658,6 +1976,9 @@ bool Map::Setup(tic_t start, bool spawnthings)
       gllump = -1;
     }
 
+  // from here on, all the map data goes into the memory region of the map
+  memregion_t *old_region = Z_SetRegion(region);
+
   LoadVertexes(lumpnum+LUMP_VERTEXES); // These are always needed.
   LoadSectors1(lumpnum+LUMP_SECTORS);  // allocates sectors
   LoadSideDefs(lumpnum+LUMP_SIDEDEFS); // allocates sidedefs
@@ -1681,7 +2002,7 @@ bool Map::Setup(tic_t start, bool spawnthings)
     }
 
   LoadSectors2(lumpnum+LUMP_SECTORS); // rest of secs, uses nothing!!!
-  rejectmatrix = static_cast<byte*>(fc.CacheLumpNum(lumpnum+LUMP_REJECT,PU_LEVEL));
+  LoadReject(lumpnum+LUMP_REJECT, gllump != -1 ? gllump+LUMP_GL_PVS : -1); // uses se, ss
   GroupLines();
 
 
@@ -1728,6 +2049,10 @@ bool Map::Setup(tic_t start, bool spawnthings)
   if (info->lightning)
     effects = new MapEffect(this); // Hexen lightning effect
 
+  BatchThinkers(); // the effect Thinkers spawned above mostly form long runs
+
+  Z_SetRegion(old_region);
+
   if (precache)
     PrecacheMap();
 
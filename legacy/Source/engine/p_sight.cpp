@@ -21,27 +21,26 @@
 /// \file
 /// \brief LineOfSight/Visibility checks, uses REJECT and BSP
 
+#include <algorithm>
+
 #include "doomdef.h"
+#include "command.h"
 
 #include "g_actor.h"
 #include "g_map.h"
+#include "g_player.h"
+#include "g_pawn.h"
 #include "p_maputl.h"
+#include "m_threads.h"
 #include "r_defs.h"
 
 
 //
 // P_CheckSight
 //
-static fixed_t sightzstart;           // eye z of looker
-static fixed_t topslope, bottomslope; // slopes to top and bottom of target
-
-static divline_t strace;                 // from t1 to t2
-static fixed_t   t2x, t2y;
-static int       sightcounts[2];
-
 
-// Returns true if strace crosses the given subsector successfully.
-bool Map::CrossSubsector(int num)
+// Returns true if q.strace crosses the given subsector successfully.
+bool Map::CrossSubsector(spatialquery_t &q, int num)
 {
 #ifdef RANGECHECK
   if (num>=numsubsectors)
@@ -61,15 +60,13 @@ bool Map::CrossSubsector(int num)
 	continue; // miniseg
 
       // allready checked other side?
-      if (line->validcount == validcount)
+      if (!q.VisitLine(line - lines))
         continue;
 
-      line->validcount = validcount;
-
       vertex_t *v1 = line->v1;
       vertex_t *v2 = line->v2;
-      int s1 = strace.PointOnSide(v1->x, v1->y);
-      int s2 = strace.PointOnSide(v2->x, v2->y);
+      int s1 = q.strace.PointOnSide(v1->x, v1->y);
+      int s2 = q.strace.PointOnSide(v2->x, v2->y);
 
       // line isn't crossed?
       if (s1 == s2)
@@ -81,21 +78,25 @@ bool Map::CrossSubsector(int num)
       divl.y = v1->y;
       divl.dx = v2->x - v1->x;
       divl.dy = v2->y - v1->y;
-      s1 = divl.PointOnSide(strace.x, strace.y);
-      s2 = divl.PointOnSide(t2x, t2y);
+      s1 = divl.PointOnSide(q.strace.x, q.strace.y);
+      s2 = divl.PointOnSide(q.t2x, q.t2y);
 
       // line isn't crossed?
       if (s1 == s2)
         continue;
 
       // stop because it is not two sided anyway
-      // might do this after updating validcount?
+      // might do this before marking the line visited?
       if ( !(line->flags & ML_TWOSIDED) )
         return false;
 
       // crosses a two sided line
       sector_t *front = seg->frontsector;
       sector_t *back = seg->backsector;
+      if (q.VisitSector(front - sectors))
+        q.sightsectors.push_back(front - sectors);
+      if (q.VisitSector(back - sectors))
+        q.sightsectors.push_back(back - sectors);
 
       // no wall to block sight with?
       if (front->floorheight == back->floorheight
@@ -121,23 +122,23 @@ bool Map::CrossSubsector(int num)
       if (openbottom >= opentop)
         return false;               // stop
 
-      float frac = strace.InterceptVector(&divl);
+      float frac = q.strace.InterceptVector(&divl);
 
       if (front->floorheight != back->floorheight)
         {
-          fixed_t slope = (openbottom - sightzstart) / frac;
-          if (slope > bottomslope)
-            bottomslope = slope;
+          fixed_t slope = (openbottom - q.sightzstart) / frac;
+          if (slope > q.bottomslope)
+            q.bottomslope = slope;
         }
 
       if (front->ceilingheight != back->ceilingheight)
         {
-          fixed_t slope = (opentop - sightzstart) / frac;
-          if (slope < topslope)
-            topslope = slope;
+          fixed_t slope = (opentop - q.sightzstart) / frac;
+          if (slope < q.topslope)
+            q.topslope = slope;
         }
 
-      if (topslope <= bottomslope)
+      if (q.topslope <= q.bottomslope)
         return false;               // stop
     }
   // passed the subsector ok
@@ -146,39 +147,237 @@ bool Map::CrossSubsector(int num)
 
 
 
-// Returns true if strace crosses the given node successfully.
-bool Map::CrossBSPNode(int bspnum)
+// Returns true if q.strace crosses the given node successfully.
+bool Map::CrossBSPNode(spatialquery_t &q, int bspnum)
 {
   if (bspnum & NF_SUBSECTOR)
     {
       if (bspnum == -1)
-        return CrossSubsector(0);
+        return CrossSubsector(q, 0);
       else
-        return CrossSubsector(bspnum & (~NF_SUBSECTOR));
+        return CrossSubsector(q, bspnum & (~NF_SUBSECTOR));
     }
 
   node_t *bsp = &nodes[bspnum];
 
   // decide which side the start point is on
-  int side = bsp->PointOnSide(strace.x, strace.y);
+  int side = bsp->PointOnSide(q.strace.x, q.strace.y);
   /*
   if (side == divline_t::LS_ON)
     side = divline_t::LS_FRONT; // an "on" should cross both sides
   */
 
   // cross the starting side
-  if (!CrossBSPNode(bsp->children[side]))
+  if (!CrossBSPNode(q, bsp->children[side]))
     return false;
 
   // the partition plane is crossed here
-  if (side == bsp->PointOnSide(t2x, t2y))
+  if (side == bsp->PointOnSide(q.t2x, q.t2y))
     {
       // the line doesn't touch the other side
       return true;
     }
 
   // cross the ending side
-  return CrossBSPNode(bsp->children[side^1]);
+  return CrossBSPNode(q, bsp->children[side^1]);
+}
+
+
+// True if REJECT says t1 cannot possibly see t2.
+static inline bool Rejected(Map *m, Actor *t1, Actor *t2)
+{
+  // Determine sector entries in REJECT table.
+  int s1 = (t1->subsector->sector - m->sectors);
+  int s2 = (t2->subsector->sector - m->sectors);
+  int pnum = s1*m->numsectors + s2;
+  int bytenum = pnum >> 3;
+  int bitnum = 1 << (pnum&7);
+
+  return m->rejectmatrix[bytenum] & bitnum;
+}
+
+
+void sightquery_t::Set(Actor *a, Actor *b)
+{
+  t1 = a;
+  t2 = b;
+  x1 = a->pos.x;
+  y1 = a->pos.y;
+  z1 = a->Top() - (a->height >> 2); // eyes
+  x2 = b->pos.x;
+  y2 = b->pos.y;
+  top2 = b->Top();
+  bottom2 = b->Feet();
+}
+
+
+// Traces the line of sight of s through the BSP, sets s.visible and appends the sectors it depends on to deps.
+// Only reads the Map geometry, so it can be run in worker threads.
+bool Map::TraceSight(spatialquery_t &q, sightquery_t &s, vector<int> &deps)
+{
+  q.Begin(this); // lines and sectors visited by earlier traces must be crossed again
+
+  // Now look from eyes of t1 to any part of t2.
+  q.sightzstart = s.z1;
+  q.topslope = s.top2 - q.sightzstart;
+  q.bottomslope = s.bottom2 - q.sightzstart;
+  q.sightsectors.clear();
+
+  /*
+  if (gamemode == gm_heretic)
+    return P_SightPathTraverse(t1->x, t1->y, t2->x, t2->y);
+  */
+
+  q.strace.x = s.x1;
+  q.strace.y = s.y1;
+  q.t2x = s.x2;
+  q.t2y = s.y2;
+  q.strace.dx = s.x2 - s.x1;
+  q.strace.dy = s.y2 - s.y1;
+
+  // the head node is the last node output
+  s.visible = CrossBSPNode(q, numnodes-1);
+  s.firstsector = deps.size();
+  s.numsectors = q.sightsectors.size();
+  deps.insert(deps.end(), q.sightsectors.begin(), q.sightsectors.end());
+  s.made = sector_moves;
+  return s.visible;
+}
+
+
+// True if none of the sectors s depends on have moved since it was traced.
+bool Map::SightValid(const sightquery_t &s) const
+{
+  if (s.made == sector_moves)
+    return true; // nothing has moved
+
+  for (unsigned i = 0; i < s.numsectors; i++)
+    if (sectors[sightsectors[s.firstsector + i]].lastmove > s.made)
+      return false;
+
+  return true;
+}
+
+
+// Forgets the sight results of the previous tic.
+void Map::ResetSight()
+{
+  sightbatch.clear();
+  sightsectors.clear();
+
+  if (sightmemo.empty() || 2*sightmemo_count > sightmemo.size())
+    {
+      // (re)allocated only between tics, never while the memo is in use
+      unsigned n = max(unsigned(SIGHTMEMO_MINSIZE), 2*unsigned(sightmemo.size()));
+      sightmemo.resize(n);
+      sightmemo_tic.assign(n, 0);
+      sightmemo_stamp = 0;
+    }
+
+  if (++sightmemo_stamp == 0)
+    {
+      // wrapped around, forget all the old slots
+      sightmemo_tic.assign(sightmemo_tic.size(), 0);
+      sightmemo_stamp = 1;
+    }
+  sightmemo_count = 0;
+
+  // sector_moves keeps growing between tics, only the lastmove marks need to be forgotten when it wraps
+  if (sector_moves >= 0x80000000u)
+    {
+      for (int i=0; i<numsectors; i++)
+	sectors[i].lastmove = 0;
+      sector_moves = 0;
+    }
+}
+
+
+// Memo hash of the exact inputs of a sight check.
+static inline Uint32 SightHash(const sightquery_t &s)
+{
+  const fixed_t *in[7] = {&s.x1, &s.y1, &s.z1, &s.x2, &s.y2, &s.top2, &s.bottom2};
+  Uint32 k = 0;
+  for (int i=0; i<7; i++)
+    k = (k ^ Uint32(in[i]->value())) * 2654435761u;
+  return k ^ (k >> 16);
+}
+
+
+/// \brief Evaluates ahead of time the sight checks the Actors from start onwards are about to make.
+/*!
+  Only Actors whose state changes during this tic run action functions, and those
+  mostly check if they can see their target, or look for players if they have none.
+  The pairs are collected and deduplicated, REJECT is tested serially and the
+  remaining BSP traversals are run in parallel by the WorkerPool.
+  CheckSight then uses a result only if its inputs have not changed since,
+  so the outcome is exactly the same as without the batch.
+*/
+void Map::BatchSight(Thinker *start)
+{
+
+  int n = players.size();
+  sightquery_t s;
+
+  for (Thinker *t = start; t != &thinkercap; t = t->next)
+    {
+      DActor *a = t->Inherits<DActor>();
+      if (!a || a->tics != 1 || (a->flags & MF_CORPSE))
+	continue; // not acting this tic
+
+      if (a->target)
+	{
+	  if (a->target->mp == this && !Rejected(this, a, a->target))
+	    {
+	      s.Set(a, a->target);
+	      sightbatch.push_back(s);
+	    }
+	}
+      else if ((a->flags & MF_COUNTKILL) && a->lastlook >= 0)
+	{
+	  // DActor::LookForEnemies checks at most two players per call
+	  for (int c = 0; c < 2 && c < n; c++)
+	    {
+	      PlayerPawn *p = players[(a->lastlook + c) % n]->pawn;
+	      if (p && !Rejected(this, a, p))
+		{
+		  s.Set(a, p);
+		  sightbatch.push_back(s);
+		}
+	    }
+	}
+    }
+
+  sort(sightbatch.begin(), sightbatch.end());
+  sightbatch.erase(unique(sightbatch.begin(), sightbatch.end(),
+			  [](const sightquery_t &a, const sightquery_t &b) { return a.t1 == b.t1 && a.t2 == b.t2; }),
+		   sightbatch.end());
+
+  n = sightbatch.size();
+  if (n == 0)
+    return;
+
+  // Only this Map and the batch are touched by the jobs, so other Maps may be ticked meanwhile.
+  parallel_section_t parallel;
+
+  const int chunk = 32;
+  int nc = (n + chunk - 1) / chunk;
+  vector< vector<int> > deps(nc); // sectors each chunk depends on, merged below in chunk order
+  workers.ParallelFor(nc, [this, n, &deps](int c)
+    {
+      query_scope_t q(this);
+      int end = min(n, (c+1) * chunk);
+      for (int i = c * chunk; i < end; i++)
+	TraceSight(*q, sightbatch[i], deps[c]);
+    });
+
+  for (int c = 0; c < nc; c++)
+    {
+      unsigned base = sightsectors.size();
+      int end = min(n, (c+1) * chunk);
+      for (int i = c * chunk; i < end; i++)
+	sightbatch[i].firstsector += base;
+      sightsectors.insert(sightsectors.end(), deps[c].begin(), deps[c].end());
+    }
 }
 
 
@@ -193,44 +392,93 @@ bool Map::CheckSight(Actor *t1, Actor *t2)
     return false;
 
   // First check for trivial rejection.
-
-  // Determine sector entries in REJECT table.
-  int s1 = (t1->subsector->sector - sectors);
-  int s2 = (t2->subsector->sector - sectors);
-  int pnum = s1*numsectors + s2;
-  int bytenum = pnum >> 3;
-  int bitnum = 1 << (pnum&7);
-
-  // Check in REJECT table.
-  if (rejectmatrix[bytenum] & bitnum)
+  if (Rejected(this, t1, t2))
     {
-      sightcounts[0]++;
+      sightstats[sight_reject]++;
 
       // can't possibly be connected
       return false;
     }
 
   // An unobstructed LOS is possible.
-  // Now look from eyes of t1 to any part of t2.
-  sightcounts[1]++;
-  validcount++;
+  sightquery_t s;
+  s.Set(t1, t2);
 
-  sightzstart = t1->Top() - (t1->height >> 2);
-  topslope = t2->Top() - sightzstart;
-  bottomslope = t2->Feet() - sightzstart;
+  // evaluated ahead of time?
+  if (!sightbatch.empty())
+    {
+      vector<sightquery_t>::iterator r = lower_bound(sightbatch.begin(), sightbatch.end(), s);
+      if (r != sightbatch.end() && r->t1 == t1 && r->t2 == t2 &&
+	  r->SameInputs(s) && SightValid(*r))
+	{
+	  sightstats[sight_batch]++;
+	  return r->visible;
+	}
+    }
 
-  /*
-  if (gamemode == gm_heretic)
-    return P_SightPathTraverse(t1->x, t1->y, t2->x, t2->y);
-  */
+  // Checked already during this tic?
+  // Only exactly the same inputs are guaranteed to give the same result,
+  // so the memo is keyed by them, whichever Actors are involved.
+  unsigned mask = sightmemo.size() - 1;
+  unsigned slot = SightHash(s) & mask;
+  for ( ; sightmemo_tic[slot] == sightmemo_stamp; slot = (slot + 1) & mask)
+    if (sightmemo[slot].SameInputs(s))
+      {
+	if (SightValid(sightmemo[slot]))
+	  {
+	    sightstats[sight_memo]++;
+	    return sightmemo[slot].visible;
+	  }
+	break; // a door or a lift has moved, trace again and replace the slot
+      }
+
+  {
+    // Only this Map and thread_local data are read from here on, so other Maps may be ticked meanwhile.
+    parallel_section_t parallel;
+
+    query_scope_t q(this);
+    TraceSight(*q, s, sightsectors);
+  }
+
+  sightstats[sight_trace]++;
+
+  // A full table just stops memoizing for the rest of the tic, ResetSight grows it.
+  if (sightmemo_tic[slot] == sightmemo_stamp)
+    sightmemo[slot] = s; // replacing a stale result
+  else if (2*sightmemo_count < sightmemo.size())
+    {
+      sightmemo[slot] = s;
+      sightmemo_tic[slot] = sightmemo_stamp;
+      sightmemo_count++;
+    }
+  else
+    sightmemo_count++; // counted anyway, so the next ResetSight grows the table
+
+  return s.visible;
+}
 
-  strace.x = t1->pos.x;
-  strace.y = t1->pos.y;
-  t2x = t2->pos.x;
-  t2y = t2->pos.y;
-  strace.dx = t2->pos.x - t1->pos.x;
-  strace.dy = t2->pos.y - t1->pos.y;
 
-  // the head node is the last node output
-  return CrossBSPNode(numnodes-1);
+// prints the sight check statistics of the current map
+void Command_SightStats_f()
+{
+  if (!com_player || !com_player->mp)
+    return;
+
+  Map *m = com_player->mp;
+  const char *names[Map::sight_numstats] = {"rejected", "batched", "memoized", "traced"};
+
+  unsigned total = 0;
+  for (int i=0; i<Map::sight_numstats; i++)
+    total += m->sightstats[i];
+
+  CONS_Printf("%u sight checks\n", total);
+  if (!total)
+    return;
+
+  for (int i=0; i<Map::sight_numstats; i++)
+    CONS_Printf("%10s: %8u (%.1f%%)\n", names[i], m->sightstats[i], 100.0 * m->sightstats[i] / total);
+
+  unsigned lookups = m->sightstats[Map::sight_memo] + m->sightstats[Map::sight_trace];
+  if (lookups)
+    CONS_Printf("memo hit rate %.1f%%, %u memo slots\n", 100.0 * m->sightstats[Map::sight_memo] / lookups, unsigned(m->sightmemo.size()));
 }
@@ -1334,6 +1334,16 @@ void scroll_t::Think()
     }
 }
 
+
+// Non-virtual Think for a batch of scroll_t's.
+void scroll_t::ThinkBatch(Thinker *const *t, int n)
+{
+  for (int i=0; i<n; i++)
+    if (t[i])
+      static_cast<scroll_t *>(t[i])->scroll_t::Think();
+}
+
+
 // Add a generalized scroller to the thinker list.
 //
 // type: the enumerated type of scrolling: floor, ceiling, floor carrier,
@@ -1580,7 +1590,7 @@ pusher_t::pusher_t(Map *m, sector_t *s, pusher_e t, fixed_t x_m, fixed_t y_m, DA
 // PIT_PushThing determines the angle and magnitude of the effect.
 // The object's x and y momentum values are changed.
 
-static pusher_t *tmpusher; // pusher structure for blockmap searches
+static thread_local pusher_t *tmpusher; // pusher structure for blockmap searches
 
 bool PIT_PushThing(Actor* thing)
 {
@@ -21,20 +21,31 @@
 /// \file
 /// \brief Part of Map class implementation. Thinkers, Map::Ticker().
 
+#include "command.h"
+#include "cvars.h"
+
+#include "g_bench.h"
 #include "g_mapinfo.h"
 #include "g_map.h"
 #include "g_game.h"
 #include "g_player.h"
 #include "g_pawn.h"
+#include "p_enemy.h"
+#include "p_spec.h"
+#include "m_profile.h"
 #include "z_zone.h"
 
 #include "r_defs.h"
+#include "r_presentation.h"
 
 
 // Resets the Thinker list
 void Map::InitThinkers()
 {
   thinkercap.prev = thinkercap.next = &thinkercap;
+  dormantcap.prev = dormantcap.next = &dormantcap;
+  dormant_playersectors.clear();
+  thinkers_done = false;
 }
 
 
@@ -66,8 +77,13 @@ void Map::DetachThinker(Thinker *t)
 // Moves a Thinker to the removal list
 void Map::RemoveThinker(Thinker *t)
 {
-  t->next->prev = t->prev;
-  t->prev->next = t->next;
+  if (!t->next)
+    static_cast<thinkerbatch_t *>(t->prev)->Remove(t); // batched
+  else
+    {
+      t->next->prev = t->prev;
+      t->prev->next = t->next;
+    }
 
   // Most Thinkers could be deleted right away (it is assumed that there will be
   // no dangling pointers, or that they have already been taken care of.)
@@ -77,32 +93,414 @@ void Map::RemoveThinker(Thinker *t)
 }
 
 
+//===========================================================
+//  Thinker batches
+//===========================================================
+
+/// Thinker classes that can be run in batches, with their batch functions.
+static const struct
+{
+  TypeInfo                    *type;
+  thinkerbatch_t::batchthink_t think;
+} batchable[] =
+{
+  {&lightfx_t::_type,     lightfx_t::ThinkBatch},
+  {&phasedlight_t::_type, phasedlight_t::ThinkBatch},
+  {&scroll_t::_type,      scroll_t::ThinkBatch}
+};
+
+/// Shorter runs are not worth batching.
+#define MIN_THINKERBATCH 8
+
+
+// Replaces runs of consecutive batchable Thinkers of one class in the ring with thinkerbatch_t's.
+// Only the class of each Thinker matters, so the result depends on the ring order alone.
+void Map::BatchThinkers()
+{
+  const int nb = sizeof(batchable)/sizeof(batchable[0]);
+
+  Thinker *t, *next;
+  for (t = thinkercap.next; t != &thinkercap; t = next)
+    {
+      TypeInfo *type = t->Type();
+      int n = 1;
+      for (next = t->next; next != &thinkercap && next->Type() == type; next = next->next)
+	n++;
+
+      if (n < MIN_THINKERBATCH)
+	continue;
+
+      int k;
+      for (k=0; k<nb && batchable[k].type != type; k++)
+	;
+      if (k == nb)
+	continue;
+
+      // the batch takes the place of the run
+      thinkerbatch_t *b = new thinkerbatch_t(batchable[k].think);
+      b->mp = this;
+      b->prev = t->prev;
+      b->next = next;
+      t->prev->next = b;
+      next->prev = b;
+
+      b->members.reserve(n);
+      while (t != next)
+	{
+	  Thinker *m = t;
+	  t = t->next;
+	  m->prev = b;
+	  m->next = NULL;
+	  b->members.push_back(m);
+	}
+      b->live = n;
+    }
+}
+
+
+// Puts the members of all thinkerbatch_t's back into the ring in their place, deletes the batches.
+void Map::UnbatchThinkers()
+{
+  Thinker *t, *next;
+  for (t = thinkercap.next; t != &thinkercap; t = next)
+    {
+      next = t->next;
+      if (t->Type() != &thinkerbatch_t::_type)
+	continue;
+
+      thinkerbatch_t *b = static_cast<thinkerbatch_t *>(t);
+      Thinker *prev = b->prev;
+      int n = b->members.size();
+      for (int i=0; i<n; i++)
+	{
+	  Thinker *m = b->members[i];
+	  if (!m)
+	    continue;
+	  m->prev = prev;
+	  prev->next = m;
+	  prev = m;
+	}
+      prev->next = next;
+      next->prev = prev;
+
+      b->members.clear(); // the members are not deleted
+      delete b;
+    }
+}
+
+
+//===========================================================
+//  Dormant DActors
+//===========================================================
+
+/*!
+  \brief Idle monsters far away from the players do not think.
+
+  With "dormantmonsters" on, in a single player game that is not a demo, a monster idling
+  in its spawn cycle (only A_Look or no action at all), without a target, standing still
+  in a sector no player can see according to REJECT, is moved from the Thinker ring
+  to the dormant ring. There its A_Look calls could not do anything anyway,
+  except advance lastlook and the animation.
+  It is moved back to the end of the Thinker ring when
+  - a noise alert reaches its sector,
+  - a player moves into a sector that is not REJECTed from its sector,
+  - it is damaged, or its state is set from outside (scripts, specials),
+  - a sector it touches moves,
+  - the periodic check finds that it no longer qualifies (pushed, teleported...).
+  The animation, lastlook and threshold are then advanced by the tics it missed.
+  A woken Actor thinks at a new place in the Thinker ring, which changes the order of
+  the P_Random calls, so the game does not stay in sync with one where nobody sleeps.
+  That is why demos and netgames never use dormancy.
+  Dormancy is saved with the game, so saving does not change the simulation.
+*/
+
+// True if the current game may use dormancy.
+static bool DormancyAllowed()
+{
+  return cv_dormantmonsters.value && !game.StrictSync();
+}
+
+// True if the spawn cycle of a contains no actions other than A_Look, and no zero-tic states.
+static bool IdleCycle(const DActor *a)
+{
+  const state_t *s = a->state;
+  for (int i=0; i<16; i++)
+    {
+      if (s->tics <= 0 || (s->action && s->action != A_Look))
+	return false;
+
+      s = s->nextstate;
+      if (!s)
+	return false;
+      if (s == a->state)
+	return true;
+    }
+  return false; // too long, or does not return to the current state
+}
+
+
+// True if a may become dormant.
+bool Map::CanSleep(DActor *a)
+{
+  if (!(a->flags & MF_COUNTKILL) || (a->flags & MF_CORPSE) || a->health <= 0
+      || (a->flags2 & MF2_FLOATBOB) || (a->eflags & (MFE_REMOVE | MFE_SKULLFLY | MFE_BLASTED)))
+    return false;
+
+  if (a->target || a->tid || a->special || a->lastlook < 0 || a->tics <= 0)
+    return false;
+
+  if (a->vel.x != 0 || a->vel.y != 0 || a->vel.z != 0)
+    return false;
+
+  if (a->pos.z != a->floorz && !(a->flags & MF_NOGRAVITY))
+    return false; // falling
+
+  sector_t *s = a->subsector->sector;
+  if (s->soundtarget || dormant_visible[s - sectors])
+    return false; // A_Look would react
+
+  // sectors that may push or carry things around
+  for (msecnode_t *n = a->touching_sectorlist; n; n = n->m_tnext)
+    if (n->m_sector->tag || n->m_sector->special)
+      return false;
+
+  return IdleCycle(a);
+}
+
+
+// Moves a from the Thinker ring to the dormant ring.
+void Map::SleepActor(DActor *a)
+{
+  a->next->prev = a->prev;
+  a->prev->next = a->next;
+
+  dormantcap.prev->next = a;
+  a->next = &dormantcap;
+  a->prev = dormantcap.prev;
+  dormantcap.prev = a;
+
+  a->eflags |= MFE_DORMANT;
+  a->sleeptic = maptic;
+}
+
+
+// Moves a dormant Actor back to the end of the Thinker ring, catching up with the tics it missed.
+void Map::WakeActor(Actor *actor)
+{
+  if ((actor->eflags & (MFE_DORMANT | MFE_REMOVE)) != MFE_DORMANT)
+    return; // awake, or removed from both rings
+
+  DActor *a = static_cast<DActor*>(actor); // only DActors become dormant
+  a->eflags &= ~MFE_DORMANT;
+
+  a->next->prev = a->prev;
+  a->prev->next = a->next;
+
+  thinkercap.prev->next = a;
+  a->next = &thinkercap;
+  a->prev = thinkercap.prev;
+  thinkercap.prev = a;
+
+  // the Thinks missed, not counting the one it had when it fell asleep,
+  // nor the one it will have in this tic (if the Thinkers have already run, that is in the next tic)
+  int missed = maptic - a->sleeptic - (thinkers_done ? 0 : 1);
+  if (missed <= 0)
+    return;
+
+  // the idle cycle repeats itself, so whole periods can be skipped
+  int period = 0, looks = 0;
+  const state_t *s = a->state;
+  do {
+    period += s->tics;
+    if (s->action == A_Look)
+      looks++;
+    s = s->nextstate;
+  } while (s != a->state);
+
+  looks *= missed / period;
+  missed %= period;
+
+  for ( ; missed > 0; missed--)
+    if (--a->tics == 0)
+      {
+	a->state = a->state->nextstate;
+	a->tics = a->state->tics;
+	if (a->state->action == A_Look)
+	  looks++;
+      }
+
+  if (looks > 0)
+    a->threshold = 0; // like A_Look does
+
+  // A_Look walks through max. two players each time, failing the REJECT test
+  int n = players.size();
+  if (n > 0)
+    for ( ; looks > 0; looks--)
+      for (int c = 0; c < n; c++, a->lastlook++)
+	{
+	  if (a->lastlook >= n)
+	    a->lastlook = 0;
+	  if (c >= 2)
+	    break;
+	}
+
+  a->pres->SetFrame(a->state);
+}
+
+
+// Wakes up the dormant Actors in the sector.
+void Map::WakeSector(sector_t *sec)
+{
+  if (dormantcap.next == &dormantcap)
+    return;
+
+  for (Actor *a = sec->thinglist; a; a = a->snext)
+    WakeActor(a);
+}
+
+
+// Wakes up every dormant Actor.
+void Map::WakeAll()
+{
+  while (dormantcap.next != &dormantcap)
+    WakeActor(static_cast<DActor*>(dormantcap.next));
+}
+
+
+// Recomputes the sectors visible from the players if they have moved, wakes up the Actors there.
+// Every second also rechecks all the dormant Actors.
+void Map::WakeVisible()
+{
+  int n = players.size();
+  vector<int> ps;
+  for (int i=0; i<n; i++)
+    if (players[i]->pawn && players[i]->pawn->subsector)
+      ps.push_back(players[i]->pawn->subsector->sector - sectors);
+
+  if (ps != dormant_playersectors || int(dormant_visible.size()) != numsectors)
+    {
+      dormant_playersectors = ps;
+      dormant_visible.assign(numsectors, 0);
+
+      // same test as in CheckSight, with the monster looking at the player
+      for (int s=0; s<numsectors; s++)
+	for (unsigned j=0; j<ps.size(); j++)
+	  {
+	    int pnum = s*numsectors + ps[j];
+	    if (!(rejectmatrix[pnum >> 3] & (1 << (pnum & 7))))
+	      {
+		dormant_visible[s] = 1;
+		break;
+	      }
+	  }
+
+      Thinker *t, *next;
+      for (t = dormantcap.next; t != &dormantcap; t = next)
+	{
+	  next = t->next;
+	  DActor *a = static_cast<DActor*>(t);
+	  if (dormant_visible[a->subsector->sector - sectors])
+	    WakeActor(a);
+	}
+    }
+
+  if (maptic % TICRATE == 0)
+    {
+      Thinker *t, *next;
+      for (t = dormantcap.next; t != &dormantcap; t = next)
+	{
+	  next = t->next;
+	  DActor *a = static_cast<DActor*>(t);
+	  a->eflags &= ~MFE_DORMANT; // CanSleep does not accept dormant ones
+	  bool ok = CanSleep(a);
+	  a->eflags |= MFE_DORMANT;
+	  if (!ok)
+	    WakeActor(a);
+	}
+    }
+}
+
+
 void Map::RunThinkers()
 {
   Thinker *t, *next; 
 
+  ResetSight();
+
+  if (DormancyAllowed())
+    WakeVisible();
+  else
+    WakeAll();
+
+  // The sight checks of this tic are batched once the players have moved.
+  Thinker *lastplayer = NULL;
+  if (cv_batchsight.value)
+    {
+      for (t = thinkercap.prev; t != &thinkercap; t = t->prev)
+	if (t->Inherits<PlayerPawn>())
+	  {
+	    lastplayer = t;
+	    break;
+	  }
+
+      if (!lastplayer)
+	BatchSight(thinkercap.next);
+    }
+
   for (t = thinkercap.next; t != &thinkercap; t = next)
     {
       next = t->next; // if t is removed while it thinks, its next pointer will no longer be valid.
       //if (t->mp == NULL) I_Error("Thinker::mp == NULL! Cannot be!\n");
       t->Think();
+
+      if (t == lastplayer)
+	BatchSight(next);
+
+      // idle monsters are checked when they enter a new state
+      if (DormancyAllowed())
+	{
+	  DActor *a = t->Inherits<DActor>();
+	  if (a && a->mp == this && a->tics == a->state->tics && CanSleep(a))
+	    SleepActor(a);
+	}
     }
+
+  thinkers_done = true;
 }
 
 
+// NULLs the pointers to removed Actors, deletes the removed Thinkers.
 void Map::PointerCleanup()
 {
   int n = DeletionList.size();
   if (n == 0 && !force_pointercheck)
     return;
 
-  for (Thinker *t = thinkercap.next; t != &thinkercap; t = t->next)
-    t->CheckPointers();
+  // The actorref_t's pointing to the removed Actors are found through their referrer lists.
+  // Only PlayerPawns are pointed to by plain pointers (voodoo doll victims, sound targets),
+  // so only their removal (or players leaving the Map) requires checking every Thinker.
+  bool sweep = force_pointercheck;
+  for (int i=0; i<n; i++)
+    {
+      Actor *a = DeletionList[i]->Inherits<Actor>();
+      if (a)
+	{
+	  a->ClearReferrers();
+	  if (a->Inherits<PlayerPawn>())
+	    sweep = true;
+	}
+    }
+
+  if (sweep)
+    {
+      for (Thinker *t = thinkercap.next; t != &thinkercap; t = t->next)
+	t->CheckPointers();
 
-  // FIXME unfortunate HACK (the entire sound alert system is unrealistic!)
-  for (int i=0 ; i<numsectors ; i++)
-    if (sectors[i].soundtarget && (sectors[i].soundtarget->eflags & MFE_REMOVE))
-      sectors[i].soundtarget = NULL;
+      // FIXME unfortunate HACK (the entire sound alert system is unrealistic!)
+      for (int i=0 ; i<numsectors ; i++)
+	if (sectors[i].soundtarget && (sectors[i].soundtarget->eflags & MFE_REMOVE))
+	  sectors[i].soundtarget = NULL;
+    }
 
   force_pointercheck = false;
 
@@ -114,35 +512,46 @@ void Map::PointerCleanup()
 
 
 // Ticks the map forward in time
-void Map::Ticker()
+void Map::Ticker(bool runthinkers)
 {
   //CONS_Printf("Tic begins..");
+  PROFILE_ZONE("Map::Ticker");
   int i = 0;
 
+  simbench_t::BeginTic();
+
   if (game.server)
     {
-      RunThinkers();
+      if (runthinkers)
+	RunThinkers();
+      simbench_t::Mark(simbench_t::RunThinkers);
 
       // after a player is respawned, its input should be built before it is used in RunThinkers.
       if (!respawnqueue.empty())
 	i = RespawnPlayers();
+      simbench_t::Mark(simbench_t::RespawnPlayers);
 
       //CONS_Printf("think..");
       //RunThinkers();
 
       //CONS_Printf("specials..");
       UpdateSpecials();
+      simbench_t::Mark(simbench_t::UpdateSpecials);
 
       //CONS_Printf("respawnspecials..");
       RespawnSpecials();
+      simbench_t::Mark(simbench_t::RespawnSpecials);
 
       //CONS_Printf("sound sequences..");
       UpdateSoundSequences();
+      simbench_t::Mark(simbench_t::UpdateSoundSequences);
 
       //CONS_Printf("FS..");
       FS_DelayedScripts();
+      simbench_t::Mark(simbench_t::FS_DelayedScripts);
 
       HandlePlayers();
+      simbench_t::Mark(simbench_t::HandlePlayers);
     }
   else
     {
@@ -159,9 +568,12 @@ void Map::Ticker()
     }
 
   PointerCleanup(); // this must be done AFTER players have left the Map, BEFORE they enter another
+  simbench_t::Mark(simbench_t::PointerCleanup);
+  simbench_t::EndTic();
 
   // for par times etc.
   maptic++;
+  thinkers_done = false;
 
   //CONS_Printf("tick done\n");
 }
@@ -456,8 +456,8 @@ void P_TeleportOther(Actor *v)
 // Mystic Ambit Incantation, class specific effect for everyone in radius
 // if only C++ had functions inside functions!
 
-static Actor *caster;
-static bool   given;
+static thread_local Actor *caster;
+static thread_local bool   given;
 
 static bool IT_HealRadius(Thinker *th)
 {
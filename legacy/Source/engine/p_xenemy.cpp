@@ -401,8 +401,8 @@ void A_MinotaurRoam(DActor *actor)
 //----------------------------------------------------------------------------
 #define MINOTAUR_LOOK_DIST		(16*54)
 
-static Actor *mino;
-extern Actor *blocksearch_self;
+static thread_local Actor *mino;
+extern thread_local Actor *blocksearch_self;
 
 static bool IT_XMinotaur(Actor *mo)
 {
@@ -2740,7 +2740,7 @@ void A_SorcDeath(DActor *actor)
 // Main action func for balls - actor is a ball
 void A_SorcBallOrbit(DActor *actor)
 {
-  DActor *parent = reinterpret_cast<DActor*>(actor->owner);
+  DActor *parent = reinterpret_cast<DActor*>(actor->owner.get());
 
   angle_t angle = 0, baseangle;
   int mode = parent->args[3];
@@ -2876,7 +2876,7 @@ void A_SorcBallOrbit(DActor *actor)
 // Increase ball orbit speed - actor is ball
 void A_AccelBalls(DActor *actor)
 {
-  DActor *sorc = reinterpret_cast<DActor*>(actor->owner);
+  DActor *sorc = reinterpret_cast<DActor*>(actor->owner.get());
 
   if (sorc->args[4] < sorc->args[2])
     {
@@ -2913,7 +2913,7 @@ void A_DecelBalls(DActor *actor)
 // Update angle if first ball - actor is ball
 void A_SorcUpdateBallAngle(DActor *actor)
 {
-  DActor *sorc = reinterpret_cast<DActor*>(actor->owner);
+  DActor *sorc = reinterpret_cast<DActor*>(actor->owner.get());
 
   if (actor->type == MT_SORCBALL1)
     sorc->special1 += ANGLE_1*sorc->args[4];
@@ -2923,7 +2923,7 @@ void A_SorcUpdateBallAngle(DActor *actor)
 // actor is ball
 void A_CastSorcererSpell(DActor *actor)
 {
-  DActor *parent = reinterpret_cast<DActor*>(actor->owner);
+  DActor *parent = reinterpret_cast<DActor*>(actor->owner.get());
   DActor *mo;
   int spell = actor->type;
   angle_t ang1,ang2;
@@ -2982,7 +2982,7 @@ void A_SpawnReinforcements(DActor *actor)
 // actor is ball
 void A_SorcOffense1(DActor *actor)
 {
-  DActor *parent = reinterpret_cast<DActor*>(actor->owner);
+  DActor *parent = reinterpret_cast<DActor*>(actor->owner.get());
   DActor *mo;
   angle_t ang1,ang2;
 
@@ -3008,7 +3008,7 @@ void A_SorcOffense1(DActor *actor)
 // actor is ball
 void A_SorcOffense2(DActor *actor)
 {
-  DActor *parent = reinterpret_cast<DActor*>(actor->owner);
+  DActor *parent = reinterpret_cast<DActor*>(actor->owner.get());
   DActor *mo;
   int delta, index;
   Actor *dest = parent->target;
@@ -3075,7 +3075,7 @@ void A_SorcFX2Split(DActor *actor)
 // Orbit FX2 about sorcerer
 void A_SorcFX2Orbit(DActor *actor)
 {
-  DActor *parent = reinterpret_cast<DActor*>(actor->owner);
+  DActor *parent = reinterpret_cast<DActor*>(actor->owner.get());
 
   angle_t angle;
   fixed_t x,y,z;
@@ -3973,7 +3973,7 @@ void A_KSpiritSeeker(DActor *actor, angle_t thresh, angle_t turnMax)
   fixed_t newZ;
   fixed_t deltaZ;
 
-  DActor *target = (DActor *)actor->owner;
+  DActor *target = (DActor *)actor->owner.get();
   if (target == NULL)
     return;
 
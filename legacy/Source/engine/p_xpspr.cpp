@@ -423,7 +423,7 @@ void A_MLightningAttack(PlayerPawn *player, pspdef_t *psp)
 
 void A_ZapMimic(DActor *actor)
 {
-  DActor *ow = reinterpret_cast<DActor*>(actor->owner);
+  DActor *ow = reinterpret_cast<DActor*>(actor->owner.get());
   if (ow)
     {
       if (ow->state >= ow->info->deathstate
@@ -491,7 +491,7 @@ void A_LightningRemove(DActor *actor)
 //
 //============================================================================
 
-Actor *blocksearch_self;
+thread_local Actor *blocksearch_self;
 
 static bool PIT_BloodscourgeLook(Actor *mo)
 {
@@ -1393,7 +1393,7 @@ static void CHolyTailRemove(Actor *actor)
 
 void A_CHolyTail(DActor *actor)
 {
-  DActor *parent = reinterpret_cast<DActor*>(actor->owner);
+  DActor *parent = reinterpret_cast<DActor*>(actor->owner.get());
 
   if (parent)
     {
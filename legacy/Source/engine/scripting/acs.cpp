@@ -32,6 +32,7 @@
 #include "command.h"
 #include "m_random.h"
 #include "m_swap.h"
+#include "m_threads.h"
 #include "r_defs.h"
 #include "r_data.h"
 #include "sounds.h"
@@ -1360,6 +1361,8 @@ void acs_t::Think()
       return;
     }
 
+  serial_section_t serial; // some opcodes use static data
+
   // run opcodes
   int result;
   for (int n = 0; n < 50000; n++) // do not get caught in infinite loops
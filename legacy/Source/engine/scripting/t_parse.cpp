@@ -40,6 +40,7 @@
 
 #include "sounds.h"
 #include "z_zone.h"
+#include "m_threads.h"
 
 #include "t_parse.h"
 #include "t_spec.h"
@@ -357,6 +358,8 @@ void script_t::continue_script(char *continue_point)
 // rover must be set
 void script_t::parse()
 {
+  serial_section_t serial; // the interpreter state is global
+
   current_script = this;
 
   // check for valid rover
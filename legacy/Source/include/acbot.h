@@ -28,6 +28,7 @@
 #include "m_fixed.h"
 #include "b_bot.h"
 
+class Thinker;
 
 /// \brief ACBot by tonyd, changes by rellik and smite-meister.
 class ACBot : public BotAI
@@ -64,6 +65,7 @@ public:
   void AimWeapon();
 
   void LookForThings();
+  void ScanThinkers(Thinker &cap);
   bool LookForSpecialLine(fixed_t *x, fixed_t *y);
 
   bool QuickReachable(Actor *a);
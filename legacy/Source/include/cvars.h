@@ -71,6 +71,9 @@ extern consvar_t cv_fastmonsters;
 extern consvar_t cv_solidcorpse;
 extern consvar_t cv_voodoodolls;
 extern consvar_t cv_infighting;
+extern consvar_t cv_parallelmaps;
+extern consvar_t cv_batchsight;
+extern consvar_t cv_dormantmonsters;
 
 // client info (server needs to know)
 extern consvar_t cv_splitscreen;
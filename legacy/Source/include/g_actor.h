@@ -161,12 +161,46 @@ enum mobjeflag_t
   // combat
   MFE_JUSTHIT       = 0x1000,  ///< Got hit, will try to attack right back.
   MFE_JUSTATTACKED  = 0x2000,  ///< Will take at least one step before attacking again.
+  MFE_DORMANT       = 0x4000,  ///< Idle DActor in the dormant ring of the Map, not thinking.
 
   MFE_REMOVE    = 0x80000000   ///< Actor will be deleted after the tic
 };
 
 
 
+class Actor;
+
+/// \brief Weak reference to an Actor.
+///
+/// Behaves like an Actor*, but each Actor keeps a list of the references pointing to it.
+/// When the Actor is deleted they are NULLed by walking that list,
+/// instead of checking the pointers of every Thinker in the Map.
+class actorref_t
+{
+  friend class Actor;
+
+  Actor      *p;
+  actorref_t  *prev, *next; ///< other references to the same Actor
+
+  inline void Link(Actor *a);
+  inline void Unlink();
+
+public:
+  actorref_t() { p = NULL; prev = next = NULL; }
+  explicit actorref_t(Actor *a) { Link(a); }
+  actorref_t(const actorref_t &r) { Link(r.p); }
+  ~actorref_t() { Unlink(); }
+
+  inline actorref_t &operator=(Actor *a) { if (a != p) { Unlink(); Link(a); } return *this; }
+  inline actorref_t &operator=(const actorref_t &r) { return operator=(r.p); }
+
+  inline operator Actor*() const { return p; }
+  inline Actor *operator->() const { return p; }
+  inline Actor *get() const { return p; } ///< for casts
+};
+
+
+
 /// \brief Basis class for all Thinkers with a well-defined location.
 /// \ingroup g_central
 /*!
@@ -298,8 +332,19 @@ public:
   byte	args[5]; ///< special arguments
   //@}
 
-  Actor *owner;   ///< Owner of this Actor. For example, for missiles this is the shooter.
-  Actor *target;  ///< Thing being chased/attacked (or NULL), also the target for missiles.
+  actorref_t owner;   ///< Owner of this Actor. For example, for missiles this is the shooter.
+  actorref_t target;  ///< Thing being chased/attacked (or NULL), also the target for missiles.
+
+  /// The actorref_t's pointing to this Actor. Not copied along with the Actor.
+  struct referrers_t
+  {
+    actorref_t *first;
+    referrers_t() { first = NULL; }
+    referrers_t(const referrers_t &r) { first = NULL; }
+    referrers_t &operator=(const referrers_t &r) { return *this; }
+  } referrers;
+
+  void ClearReferrers(); ///< NULLs all the references to this Actor
 
   int reactiontime; ///< Time (in tics) before the thing can attack or move again. For MF2_FLOATBOB actors this is the bob phase.
 
@@ -378,7 +423,7 @@ protected:
   void BounceWall(fixed_t nx, fixed_t ny);
 public:
   Actor *AimLineAttack(angle_t ang, float distance, float& sinpitch);
-  Actor *LineTrace(angle_t ang, float distance, float sine, bool interact);
+  Actor *LineTrace(struct spatialquery_t &q, angle_t ang, float distance, float sine, bool interact);
   Actor *LineAttack(angle_t ang, float distance, float sine, int damage, int dtype = dt_normal);
   void   RadiusAttack(Actor *culprit, int damage, fixed_t radius = -1, int dtype = dt_normal, bool downer = true);
 
@@ -386,6 +431,39 @@ public:
 };
 
 
+inline void actorref_t::Link(Actor *a)
+{
+  p = a;
+  prev = NULL;
+  if (a)
+    {
+      next = a->referrers.first;
+      if (next)
+	next->prev = this;
+      a->referrers.first = this;
+    }
+  else
+    next = NULL;
+}
+
+inline void actorref_t::Unlink()
+{
+  if (!p)
+    return;
+
+  if (prev)
+    prev->next = next;
+  else
+    p->referrers.first = next;
+
+  if (next)
+    next->prev = prev;
+
+  p = NULL;
+  prev = next = NULL;
+}
+
+
 //========================================================
 /// \brief Doom Actor.
 /// \ingroup g_central
@@ -416,6 +494,7 @@ public:
 
   Sint16  threshold;  ///< If >0, the current target will be chased no matter what (even if shot)
   Sint16  lastlook;   ///< Player number last looked for.
+  Uint32  sleeptic;   ///< Map::maptic when it became dormant.
 
   Sint32  special1, special2, special3; ///< mobjtype dependent general storage
 
@@ -0,0 +1,77 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Headless simulation benchmark.
+
+#ifndef g_bench_h
+#define g_bench_h 1
+
+#include <chrono>
+#include <vector>
+
+using namespace std;
+
+
+/// \brief Per-phase timing of Map::Ticker during a "benchsim" run.
+/*!
+  While a benchmark is running, Map::Ticker calls BeginTic at its start and Mark
+  after each of its phases. Both do nothing when no benchmark is active.
+*/
+class simbench_t
+{
+public:
+  /// phases of Map::Ticker
+  enum phase_e
+  {
+    RunThinkers,
+    RespawnPlayers,
+    UpdateSpecials,
+    RespawnSpecials,
+    UpdateSoundSequences,
+    FS_DelayedScripts,
+    HandlePlayers,
+    PointerCleanup,
+    Total, ///< the whole tic
+    NUM_PHASES
+  };
+
+  static const char *phasenames[NUM_PHASES];
+  static simbench_t *active; ///< the running benchmark, or NULL
+
+protected:
+  typedef chrono::steady_clock clock;
+
+  clock::time_point tic_start, last;
+  double            current[NUM_PHASES]; ///< times of the current tic
+  vector<float>     times[NUM_PHASES];   ///< per-tic times in ms
+
+  void AddTime(phase_e p);
+
+public:
+  static inline void BeginTic() { if (active) active->Begin(); }
+  static inline void Mark(phase_e p) { if (active) active->AddTime(p); }
+  static inline void EndTic() { if (active) active->End(); }
+
+  void Begin();
+  void End();
+
+  /// Prints the results, writes them into a JSON file if fname is not NULL.
+  void Report(const char *mapname, int bots, double load_ms, double run_ms, const char *fname);
+};
+
+#endif
@@ -23,11 +23,12 @@
 #ifndef g_blockmap_h
 #define g_blockmap_h 1
 
+#include <vector>
 #include "vect.h"
 #include "m_fixed.h"
 
-typedef bool (*traverser_t)(struct intercept_t *in);
-typedef bool (*line_iterator_t)(struct line_t *l);
+typedef bool (*traverser_t)(struct spatialquery_t &q, struct intercept_t *in);
+typedef bool (*line_iterator_t)(struct spatialquery_t &q, struct line_t *l);
 typedef bool (*thing_iterator_t)(class Actor *a);
 
 
@@ -36,23 +37,43 @@ typedef bool (*thing_iterator_t)(class Actor *a);
   Created from axis aligned bounding box of the map, a rectangular array of
   blocks of size 128 map units square. See blockmapheader_t.
   Used to speed up collision detection agains lines and things by a spatial subdivision in 2D.
+  The blocklists are always kept in 32 bits, whatever the format they were loaded from,
+  so maps with 65535 or more lines work too.
 */
 class blockmap_t
 {
 private:
 #define MAPBLOCKUNITS   128
 #define MAPBLOCKBITS    7
-#define MAPBLOCK_END    static_cast<Uint16>(0xFFFF) ///< terminator for a blocklist
+#define MAPBLOCK_END    static_cast<Uint32>(0xFFFFFFFF) ///< terminator for a blocklist
 
   fixed_t  orgx, orgy;    ///< origin (lower left corner) of block map in map coordinates
   int      width, height; ///< size of the blockmap in mapblocks
 
-  Uint16  *lists;  ///< packed array of -1 terminated blocklists
+  Uint32  *lists;     ///< packed array of -1 terminated blocklists
+  int      list_size; ///< number of entries in lists
+
+  /// \brief Compact copies of the blocklist lines, at the same indices as in lists.
+  /*!
+    Holds what the line-box tests of IterateLinesRadius need, so they can scan
+    contiguous arrays instead of following each line_t and its vertices.
+  */
+  struct blocklines_t
+  {
+#define ST_MOVING 0xFF ///< slopetype of polyobj lines, which are always tested using the line_t itself
+    fixed_t *left, *right, *bottom, *top; ///< bounding boxes
+    fixed_t *x, *y;    ///< first vertex
+    fixed_t *dx, *dy;  ///< second vertex - first vertex
+    byte    *slopetype;
+  };
+
+  blocklines_t bl;
+  void        *bl_data; ///< memory for the arrays in bl
 
   /// Each blockmap cell contains a line_t, polyobj_t and Actor list.
   struct blockmapcell_t
   {
-    Uint16  *blocklist;  ///< blocklist pointer (for line_t's)
+    Uint32  *blocklist;  ///< blocklist pointer (for line_t's)
     struct polyblock_t *polys; ///< polyblock chain
     Actor   *actors;   ///< thing chain
   };
@@ -62,16 +83,26 @@ private:
   inline int BlockX(fixed_t x) const { return (x - orgx).floor() >> MAPBLOCKBITS; }
   inline int BlockY(fixed_t y) const { return (y - orgy).floor() >> MAPBLOCKBITS; }
   
-  bool LinesIterator(int x, int y, line_iterator_t func);
+  bool LinesIterator(struct spatialquery_t &q, int x, int y, line_iterator_t func);
+  bool LinesBoxIterator(struct spatialquery_t &q, int x, int y, const struct bbox_t &b, line_iterator_t func);
   bool ThingsIterator(int x, int y, thing_iterator_t func);
 
+  void Generate();  ///< builds the blocklists from the lines of parent_map
+  bool ReadCache(const byte *key);
+  void WriteCache(const byte *key) const;
+
 public:
-  class Map *parent_map;  ///< TODO unnecessary if we used line_t*'s instead of Uint16 indices in the blocklists...
+  class Map *parent_map;  ///< TODO unnecessary if we used line_t*'s instead of Uint32 indices in the blocklists...
 
-  blockmap_t(int lump);
+  blockmap_t(int lump, int numlines);
   blockmap_t(Map *mp);
   ~blockmap_t();
 
+  /// Copies the line data into the compact arrays, call when parent_map is set.
+  void BuildLineData();
+  /// Marks the lines that move (polyobjs) so that their stale copies are never used.
+  void SetMovingLines(const std::vector<bool> &moving);
+
   /// Replaces the Actor * in the cell of (x,y), returns the old one.
   Actor *Replace(fixed_t x, fixed_t y, Actor *a)
   {
@@ -98,7 +129,7 @@ public:
   bool IterateLinesRadius(fixed_t x, fixed_t y, fixed_t radius, line_iterator_t func);
   bool IterateThingsRadius(fixed_t x, fixed_t y, fixed_t radius, thing_iterator_t func);
   bool RoughBlockSearch(Actor *center, int distance, thing_iterator_t func);
-  bool PathTraverse(const vec_t<fixed_t>& p1, const vec_t<fixed_t>& p2, int flags, traverser_t trav);
+  bool PathTraverse(struct spatialquery_t &q, const vec_t<fixed_t>& p1, const vec_t<fixed_t>& p2, int flags, traverser_t trav);
 
   inline fixed_t FracX(fixed_t x) const { return (x - orgx) % MAPBLOCKUNITS; }
   inline fixed_t FracY(fixed_t y) const { return (y - orgy) % MAPBLOCKUNITS; }
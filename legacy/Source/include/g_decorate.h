@@ -42,6 +42,8 @@ using namespace std;
  */
 class ActorInfo
 {
+  friend class ActorInfoDictionary;
+
   enum
   {
     CLASSNAME_LEN = 63
@@ -239,6 +241,15 @@ public:
 
 
   int  Clear();
+
+  /// \name Binary snapshots of the dictionary, see g_snapshot.cpp.
+  /// key identifies the resource files the dictionary was built from, see FileCache::GetIdentityKey.
+  //@{
+  /// Writes the dictionary into a file. Returns false if some pointers could not be encoded.
+  bool SaveSnapshot(const char *filename, const byte *key);
+  /// Replaces the classes with the ones in the file, creating the missing ones. Returns false and changes nothing if the file is missing, stale or damaged.
+  bool LoadSnapshot(const char *filename, const byte *key);
+  //@}
 };
 
 
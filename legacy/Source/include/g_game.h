@@ -247,6 +247,7 @@ public:
   void WriteDemoTiccmd(ticcmd_t* cmd, int playernum);
   void StopDemo();
   bool CheckDemoStatus();
+  bool StrictSync();
 };
 
 
@@ -43,6 +43,39 @@ typedef bool (*thing_iterator_t)(class Actor *a);
 typedef bool (*thinker_iterator_t)(Thinker *t);
 
 
+/// \brief Line of sight check between two Actors, along with everything its result depends on.
+/// \ingroup g_trace
+/*!
+  Apart from the positions below, the result only depends on the floor and ceiling heights
+  of the sectors listed in Map::sightsectors. See Map::SightValid.
+*/
+struct sightquery_t
+{
+  class Actor *t1, *t2;
+  fixed_t x1, y1, z1;    ///< eye position of t1
+  fixed_t x2, y2;        ///< position of t2
+  fixed_t top2, bottom2; ///< vertical extent of t2
+  unsigned firstsector, numsectors; ///< range of Map::sightsectors whose heights were tested
+  Uint32  made;          ///< Map::sector_moves when the check was traced
+  bool    visible;       ///< the result
+
+  /// Reads the inputs of the check from the Actors.
+  void Set(class Actor *a, class Actor *b);
+
+  /// Does q have exactly the same inputs?
+  inline bool SameInputs(const sightquery_t &q) const
+  {
+    return x1 == q.x1 && y1 == q.y1 && z1 == q.z1 && x2 == q.x2 && y2 == q.y2
+      && top2 == q.top2 && bottom2 == q.bottom2;
+  }
+
+  inline bool operator<(const sightquery_t &q) const
+  {
+    return t1 < q.t1 || (t1 == q.t1 && t2 < q.t2);
+  }
+};
+
+
 /// \brief A single game map and all the stuff it contains.
 /// \nosubgrouping
 /// \ingroup g_central
@@ -66,6 +99,9 @@ public:
   int   kills, items, secrets; ///< map totals
 
   bool hexen_format; ///< is this map stored in the Hexen format?
+  byte rndindex;     ///< P_Random index used while the thinkers are run in parallel with other Maps, see MapCluster::Ticker
+
+  class memregion_t *region; ///< memory region holding the map data, released all at once when the Map is deleted
   //@}
 
   /// \name Geometry
@@ -129,6 +165,23 @@ public:
   byte *rejectmatrix;
   //@}
 
+  /// \name Line of sight
+  /// Sight results of the current tic, reused as long as nothing they depend on changes.
+  //@{
+  vector<sightquery_t> sightbatch; ///< evaluated ahead of time in parallel, sorted by looker and target
+  vector<sightquery_t> sightmemo;  ///< traced during the tic, open addressing hash table keyed by the exact inputs
+  vector<Uint32> sightmemo_tic;    ///< slot i of sightmemo is in use if sightmemo_tic[i] == sightmemo_stamp
+  Uint32   sightmemo_stamp;
+  unsigned sightmemo_count;        ///< slots in use
+  vector<int> sightsectors;        ///< numbers of the sectors the sight results of this tic depend on
+  Uint32 sector_moves;             ///< floor/ceiling moves so far, see sector_t::lastmove
+
+  enum { sight_reject, sight_batch, sight_memo, sight_trace, sight_numstats };
+  /// How many slots sightmemo starts with, it grows if a tic fills more than half of them.
+  enum { SIGHTMEMO_MINSIZE = 256 };
+  unsigned sightstats[sight_numstats]; ///< how the sight checks have been answered
+  //@}
+
 
   /// \name Scripting
   //@{
@@ -167,6 +220,10 @@ public:
   struct mapthing_t *mapthings;    ///< things
 
   Thinker thinkercap; ///< Linked list of Thinkers in the map. The head and tail of the thinker list.
+  Thinker dormantcap; ///< Ring of idle DActors that do not think until something wakes them up.
+  vector<byte> dormant_visible;       ///< sectors not REJECTed from some player sector
+  vector<int>  dormant_playersectors; ///< player sectors dormant_visible was computed for
+  bool         thinkers_done;         ///< RunThinkers has already been called during this tic
 
   bool        force_pointercheck; ///< force a Thinker pointer cleanup
   vector<Thinker *> DeletionList; ///< Thinkers to be deleted are stored here
@@ -212,6 +269,7 @@ public:
   // TODO: from this line on it's badly designed stuff to be fixed someday
   vector<mapthing_t *> braintargets; // DoomII demonbrain spawnbox targets
   int braintargeton;
+  bool braineasy;    // on easy skill levels only every other A_BrainSpit shoots
 
   vector<mapthing_t *> BossSpots;
   vector<mapthing_t *> MaceSpots;
@@ -228,14 +286,22 @@ public:
   int  Unserialize(LArchive &a);
 
   // in p_tick.cpp
-  void Ticker();
+  void Ticker(bool runthinkers = true); ///< runthinkers is false if RunThinkers has already been called for this tic
 
   void InitThinkers();
   void AddThinker(Thinker *thinker);
   void DetachThinker(Thinker *thinker);
   void RemoveThinker(Thinker *thinker);
+  void BatchThinkers();
+  void UnbatchThinkers();
   void RunThinkers();
   void PointerCleanup();
+  bool CanSleep(DActor *a);
+  void SleepActor(DActor *a);
+  void WakeActor(Actor *a);
+  void WakeSector(sector_t *sec);
+  void WakeAll();
+  void WakeVisible();
 
   // in g_map.cpp
   void AddPlayer(PlayerInfo *p); // adds a new player to the map (and respawnqueue)
@@ -300,10 +366,15 @@ public:
   void LoadGLSubsectors(const int lump, const int glversion);
   void LoadGLNodes(const int lump, const int glversion);
   void LoadGLVis(const int lump);
+  void LoadReject(int lump, int vislump); // in p_reject.cpp
 
   // in p_sight.cpp
-  bool CrossSubsector(int num);
-  bool CrossBSPNode(int bspnum);
+  bool CrossSubsector(struct spatialquery_t &q, int num);
+  bool CrossBSPNode(struct spatialquery_t &q, int bspnum);
+  bool TraceSight(struct spatialquery_t &q, sightquery_t &s, vector<int> &deps);
+  bool SightValid(const sightquery_t &s) const;
+  void ResetSight();
+  void BatchSight(Thinker *start);
   bool CheckSight(Actor *t1, Actor *t2);
   bool CheckSight2(Actor *t1, Actor *t2, fixed_t nx, fixed_t ny, fixed_t nz);
 
@@ -139,8 +139,8 @@ public:
   MapInfo();
   ~MapInfo();
 
-  /// Ticks the map forward in time.
-  void Ticker();
+  /// Ticks the map forward in time. If runthinkers is false, the thinkers have already been run for this tic.
+  void Ticker(bool runthinkers = true);
 
   /// Inserts a player into the map and activates it if necessary.
   bool Activate(class PlayerInfo *p);
@@ -102,7 +102,7 @@ public:
   float toughness; ///< Natural armor, depends on pclass.
 
   int attackphase; ///< Counter for the more complex weapons.
-  Actor *attacker; ///< Who last damaged the Pawn? (NULL for floors/ceilings).
+  actorref_t attacker; ///< Who last damaged the Pawn? (NULL for floors/ceilings).
 
 public:
   Pawn(fixed_t x, fixed_t y, fixed_t z, int type);
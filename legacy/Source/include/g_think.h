@@ -106,8 +106,17 @@ public:
   TypeInfo          *parent;  ///< parent class TypeInfo (or NULL)
   // could contain even more info about the class
 
+  /// \name Allocation statistics
+  //@{
+  unsigned size;      ///< instance size in bytes
+  unsigned allocated; ///< instances created so far
+  unsigned live;      ///< instances currently alive
+  unsigned peak;      ///< max. number of simultaneously alive instances
+  //@}
+
   TypeInfo(const char *n, thinker_factory_t f, TypeInfo *par);
   static TypeInfo *Find(unsigned code); ///< Searches the ID map for 'code'
+  static void PrintStats(); ///< Prints the allocation statistics of all classes
 };
 
 
@@ -120,6 +129,8 @@ protected: \
 public: \
   static  TypeInfo _type; \
   virtual TypeInfo *Type() const { return &_type; } \
+  void *operator new(size_t size) { return Thinker::Alloc(size, &_type); } \
+  void  operator delete(void *mem, size_t size) { Thinker::Free(mem, size, &_type); } \
   cls(); \
   virtual int Marshal(LArchive &a);
 
@@ -189,9 +200,46 @@ public:
   inline Thinker *Next() const { return next; };
   inline Thinker *Prev() const { return prev; };
 
-  /// memory management
-  void *operator new(size_t size);
-  void  operator delete(void *mem);
+  /// memory management, used by the operators new and delete of all Thinker classes
+  static void *Alloc(size_t size, TypeInfo *t);
+  static void  Free(void *mem, size_t size, TypeInfo *t);
+};
+
+
+/// \brief A run of consecutive Thinkers of one class, updated in a tight loop.
+/// \ingroup g_central
+/*!
+  Simple effect Thinkers (lights, scrollers) are mostly spawned in long runs during
+  map setup. Map::BatchThinkers replaces each such run in the Thinker ring with a single
+  thinkerbatch_t that keeps the members in a contiguous array and runs them through
+  a non-virtual batch function of their class, in their original order.
+  The global order of execution is therefore unchanged.
+
+  The members are unlinked from the ring: their next pointer is NULL, and their prev
+  pointer points to the batch. Batches are never serialized, see Map::UnbatchThinkers.
+*/
+class thinkerbatch_t : public Thinker
+{
+  friend class Map;
+  DECLARE_CLASS(thinkerbatch_t)
+
+public:
+  /// Thinks the n Thinkers in t in order, skipping NULLs. Must not change t.
+  typedef void (*batchthink_t)(Thinker *const *t, int n);
+
+protected:
+  batchthink_t      think;   ///< batch function of the member class
+  vector<Thinker *> members; ///< in ring order, NULL for removed members
+  int               live;    ///< number of non-NULL members
+
+public:
+  thinkerbatch_t(batchthink_t f);
+  virtual ~thinkerbatch_t();
+
+  virtual void Think();
+  virtual void ClientThink();
+
+  void Remove(Thinker *t); ///< removes a member, leaving a NULL in its place
 };
 
 #endif
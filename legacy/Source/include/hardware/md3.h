@@ -155,6 +155,9 @@ public:
   MD3_t();
   ~MD3_t();
 
+  /// bytes of model data held
+  unsigned Size() const;
+
   /// Read the model from a *.md3 file.
   bool Load(const string& filename);
 
@@ -271,6 +274,8 @@ public:
   MD3_player(const char *n);
   virtual ~MD3_player();
 
+  virtual unsigned Size();
+
   bool Load(const string& path, const string& skin);
   bool LoadAnim(const string& filename);
 };
@@ -280,6 +285,9 @@ class modelcache_t : public cache_t<MD3_player>
 {
 protected:
   MD3_player *Load(const char *name);
+
+public:
+  modelcache_t() : cache_t<MD3_player>("models") {}
 };
 
 
@@ -126,6 +126,9 @@ class shader_cache_t : public cache_t<Shader>
 {
 protected:
   virtual Shader *Load(const char *name) { return NULL; };
+
+public:
+  shader_cache_t() : cache_t<Shader>("shaders") {}
 };
 
 extern shader_cache_t shaders;
@@ -136,6 +139,9 @@ class shaderprog_cache_t : public cache_t<ShaderProg>
 {
 protected:
   virtual ShaderProg *Load(const char *name) { return new ShaderProg(name); };
+
+public:
+  shaderprog_cache_t() : cache_t<ShaderProg>("shaderprogs") {}
 };
 
 extern shaderprog_cache_t shaderprogs;
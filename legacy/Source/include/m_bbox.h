@@ -62,6 +62,7 @@ struct bbox_t
   bool BoxTouchBox(const bbox_t &other) const;
   bool LineCrossesEdge(const fixed_t x1, const fixed_t y1, const fixed_t x2, const fixed_t y2) const; 
   int  BoxOnLineSide(const struct line_t *ld) const;
+  int  BoxOnLineSide(fixed_t x, fixed_t y, fixed_t dx, fixed_t dy, int slopetype) const;
 };
 
 #endif
@@ -0,0 +1,123 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Scoped hot path profiler and startup stage timing.
+
+#ifndef m_profile_h
+#define m_profile_h 1
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+
+/// \brief Records timed zones into per-thread ring buffers, exports them as a Chrome trace.
+///
+/// Capturing is started and stopped with the "profile" console command. The result can be
+/// opened in chrome://tracing or Perfetto. When not capturing, a zone costs one relaxed atomic load.
+/// Building with NO_PROFILER removes the zones altogether.
+class profiler_t
+{
+public:
+  typedef std::chrono::steady_clock clock;
+
+  static std::atomic<bool> capturing; ///< zones are recorded only while this is set
+  static clock::time_point t0;        ///< beginning of the capture
+
+  static void Start();
+  /// Stops capturing, writes the recorded zones into a Chrome trace file, prints a summary.
+  static void Stop(const char *fname);
+  /// Adds a zone to the buffer of the calling thread.
+  static void Record(const char *name, clock::time_point start, clock::time_point end);
+};
+
+
+/// \brief Records the time spent in a scope as a profiler zone. Use through PROFILE_ZONE.
+class profzone_t
+{
+  const char *name; ///< NULL if not capturing
+  profiler_t::clock::time_point start;
+
+public:
+  profzone_t(const char *n)
+  {
+    name = profiler_t::capturing.load(std::memory_order_relaxed) ? n : NULL;
+    if (name)
+      start = profiler_t::clock::now();
+  }
+
+  ~profzone_t()
+  {
+    if (name)
+      profiler_t::Record(name, start, profiler_t::clock::now());
+  }
+};
+
+
+/// Profiles the rest of the enclosing scope. The name must be a string literal.
+#ifdef NO_PROFILER
+# define PROFILE_ZONE(name)
+#else
+# define PROFILE_ZONE(name) profzone_t profzone(name)
+#endif
+
+
+
+/// \brief Wall time of the initialization stages, for the -startuptimes report.
+///
+/// Stages are timed using stagetimer_t and may be nested. Nothing is recorded outside Start and Stop,
+/// so the timers can be left in functions that are also called later. Main thread only.
+class startuptimes_t
+{
+  struct stage_t
+  {
+    const char *name;
+    int    depth;      ///< nesting level
+    double start, end; ///< in ms since Start
+  };
+
+  static std::vector<stage_t> stages;
+  static bool   recording;
+  static int    depth;
+  static double total; ///< wall time from Start to Stop in ms
+  static profiler_t::clock::time_point t0;
+
+  static double Now();
+
+public:
+  static void Start();
+  static void Stop();
+  /// Begins a stage, returns its number or -1 if not recording.
+  static int  Begin(const char *name);
+  static void End(int s);
+  /// Prints the timing of each stage.
+  static void PrintReport();
+};
+
+
+/// \brief Records the time spent in a scope as a startup stage.
+class stagetimer_t
+{
+  int stage;
+
+public:
+  stagetimer_t(const char *name) { stage = startuptimes_t::Begin(name); }
+  ~stagetimer_t() { startuptimes_t::End(stage); }
+};
+
+#endif
@@ -56,4 +56,8 @@ byte P_GetRandIndex();
 
 void P_SetRandIndex(byte rindex);
 
+/// Makes P_Random in this thread use and advance the given index instead of the global one,
+/// or the global one again if rindex is NULL. Returns the previous source.
+byte *P_SetRandSource(byte *rindex);
+
 #endif
@@ -0,0 +1,144 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Worker thread pool.
+
+#ifndef m_threads_h
+#define m_threads_h 1
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/// \brief A set of jobs which can be waited on together.
+class jobgroup_t
+{
+  friend class WorkerPool;
+
+  int pending; ///< jobs submitted but not yet finished
+
+public:
+  jobgroup_t() { pending = 0; }
+};
+
+
+/// \brief Fixed set of worker threads executing queued jobs.
+///
+/// The threads are started at the first Submit. The number of workers defaults to
+/// the number of CPU cores minus one, and can be set using "-threads <n>".
+/// With zero workers all jobs are run by the thread calling Wait.
+/// Jobs must not use the zone allocator, the console or I_Error, none of which are thread safe.
+class WorkerPool
+{
+private:
+  struct job_t
+  {
+    std::function<void()> func;
+    jobgroup_t *group;
+  };
+
+  std::vector<std::thread> threads;
+  std::deque<job_t> queue;
+  std::mutex lock;
+  std::condition_variable work_cv; ///< signaled when a job is queued
+  std::condition_variable done_cv; ///< signaled when a job group is finished
+  bool started, quit;
+
+  void Start();
+  void Worker();
+  /// Runs the queued job i, lock must be held.
+  void RunJob(std::unique_lock<std::mutex> &l, std::deque<job_t>::iterator i);
+
+public:
+  WorkerPool();
+  ~WorkerPool();
+
+  /// Number of worker threads, not counting the caller of Wait.
+  int NumThreads();
+  /// Queues a job as a part of the given group.
+  void Submit(jobgroup_t &g, const std::function<void()> &job);
+  /// Blocks until all the jobs in the group are finished. Runs queued jobs of the same group while waiting.
+  void Wait(jobgroup_t &g);
+  /// Runs func(i) for i in [0, n), in parallel, returns when all are done.
+  void ParallelFor(int n, const std::function<void(int)> &func);
+  /// Stops and joins all the worker threads.
+  void Shutdown();
+};
+
+extern WorkerPool workers;
+
+
+/// \brief Serializes jobs running code which is not thread safe, except for marked parallel sections.
+///
+/// While the main thread is blocked waiting for the jobs, a job holding the lock may do anything the main thread could,
+/// including using the zone allocator and the console.
+/// A job may release the lock temporarily using parallel_section_t, around code which only touches data owned by the job
+/// and thread_local scratch variables. Code that keeps shared state alive across calls which may contain parallel sections
+/// must be wrapped in a serial_section_t.
+class biglock_t
+{
+  friend class WorkerPool;
+  friend class parallel_section_t;
+  friend class serial_section_t;
+
+  std::mutex m;
+  static thread_local biglock_t *held; ///< lock held by this thread, or NULL
+  static thread_local int serial;      ///< serial_section_t nesting depth in this thread
+  static thread_local int jobs;        ///< nesting depth of the jobs run by this thread
+
+public:
+  void Lock()   { m.lock(); held = this; }
+  void Unlock() { held = NULL; m.unlock(); }
+
+  /// True if this thread may touch code which is not thread safe: it is not running a job, or the job holds a lock.
+  static bool Serialized() { return !jobs || held; }
+};
+
+
+/// \brief Releases the biglock_t held by this thread for the duration of the scope, unless in a serial_section_t.
+///
+/// Does nothing if the thread holds no lock, so it costs next to nothing in single threaded code.
+class parallel_section_t
+{
+  biglock_t *released;
+
+public:
+  parallel_section_t()
+  {
+    released = biglock_t::serial ? NULL : biglock_t::held;
+    if (released)
+      released->Unlock();
+  }
+  ~parallel_section_t() { if (released) released->Lock(); }
+};
+
+
+/// \brief Keeps the biglock_t held by this thread for the duration of the scope, see parallel_section_t.
+class serial_section_t
+{
+public:
+  serial_section_t()  { biglock_t::serial++; }
+  ~serial_section_t() { biglock_t::serial--; }
+};
+
+
+#endif
@@ -26,14 +26,12 @@
 #include <vector>
 #include "r_defs.h"
 #include "tables.h"
+#include "g_blockmap.h"
 
 using namespace std;
 
 #define USERANGE 64
 
-extern int validcount;
-
-
 
 /// \brief Vertical range.
 struct range_t
@@ -94,8 +92,6 @@ struct intercept_t
 /// \ingroup g_trace
 struct trace_t
 {
-  typedef bool (*traverser_t)(intercept_t *in);
-
   class Map     *mp;    ///< Necessary, since line_t's don't carry a Map *. Actors do.  
   vec_t<fixed_t> start; ///< starting point
   vec_t<fixed_t> delta; ///< == end-start
@@ -114,9 +110,6 @@ public:
   /// Initializes the trace.
   void Init(const vec_t<fixed_t>& v1, const vec_t<fixed_t>& v2);
 
-  /// Traverses the accumulated intercepts in order of closeness up to maxfrac.
-  bool TraverseIntercepts(traverser_t func, float maxfrac);
-
   /// Returns a point along the trace, f is in [0,1].
   inline vec_t<fixed_t> Point(float f) { return start + delta * f; }
 
@@ -124,7 +117,85 @@ public:
   bool HitZPlane(struct sector_t *s);
 };
 
-extern trace_t trace;
+
+
+/// \brief Scratch state of a single spatial query: blockmap iteration, line trace or line of sight check.
+/// \ingroup g_trace
+/*!
+  Replaces the global validcount marks and the static trace/sight variables.
+  The visited line_t/sector_t/polyobj_t marks are kept here instead of in the map data,
+  so concurrent queries never write into shared structures.
+  The context is handed to every \ref g_pit PIT and \ref g_ptr PTR function the query calls.
+  Use a query_scope_t to get one.
+*/
+struct spatialquery_t
+{
+  class Map *mp;  ///< Map being queried
+
+  /// \name Visited marks, an element is visited during this query if it equals stamp.
+  //@{
+  Uint32 stamp;
+  vector<Uint32> linemarks;
+  vector<Uint32> sectormarks;
+  vector<Uint32> polymarks;
+  //@}
+
+  trace_t trace;  ///< used by blockmap_t::PathTraverse
+  bool earlyout;  ///< stop the trace at the first solid line?
+
+  /// \name Line of sight, used by Map::CheckSight
+  //@{
+  fixed_t   sightzstart;           ///< eye z of looker
+  fixed_t   topslope, bottomslope; ///< slopes to top and bottom of target
+  divline_t strace;                ///< from t1 to t2
+  fixed_t   t2x, t2y;
+  vector<int> sightsectors;        ///< numbers of the sectors whose heights were tested
+  //@}
+
+public:
+  spatialquery_t() : mp(NULL), stamp(0) {}
+
+  /// Starts a new query on Map m, nothing is visited after this.
+  void Begin(Map *m);
+
+  /// Marks line n visited, returns false if it already was.
+  inline bool VisitLine(int n)    { return Visit(linemarks, n); }
+  /// Marks sector n visited, returns false if it already was.
+  inline bool VisitSector(int n)  { return Visit(sectormarks, n); }
+  /// Marks polyobj n visited, returns false if it already was.
+  inline bool VisitPolyobj(int n) { return Visit(polymarks, n); }
+
+  /// Traverses the accumulated trace intercepts in order of closeness up to maxfrac.
+  bool TraverseIntercepts(traverser_t func, float maxfrac);
+
+private:
+  inline bool Visit(vector<Uint32>& marks, int n)
+  {
+    if (marks[n] == stamp)
+      return false;
+    marks[n] = stamp;
+    return true;
+  }
+};
+
+
+/// \brief Borrows a spatialquery_t for the lifetime of the scope.
+/// \ingroup g_trace
+/*!
+  Each thread has its own stack of contexts. A query started from inside
+  a PIT/PTR function gets the next one, so it cannot clobber the query that called it.
+*/
+class query_scope_t
+{
+  spatialquery_t *q;
+
+public:
+  explicit query_scope_t(Map *m);
+  ~query_scope_t();
+
+  inline spatialquery_t& operator*()  const { return *q; }
+  inline spatialquery_t* operator->() const { return q; }
+};
 
 
 /// \brief Flags for Map::PathTraverse
@@ -160,5 +231,6 @@ struct position_check_t
 
 
 int  P_PointOnLineSide(const fixed_t x, const fixed_t y, const line_t *line);
+int  P_PointOnLineSide(const fixed_t x, const fixed_t y, const fixed_t lx, const fixed_t ly, const fixed_t ldx, const fixed_t ldy);
 
 #endif
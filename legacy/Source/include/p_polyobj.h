@@ -57,7 +57,6 @@ struct polyobj_t
   class polyobject_t *thinker; ///< pointer to a Thinker, if the polyobj is moving
 
   bool bad; ///< is the polyobj invalid?
-  int validcount;
 
   bool Build();
   /// Move polyobj by (dx, dy).
@@ -55,7 +55,7 @@ struct pspdef_t
 };
 
 
-extern struct line_t  *target_line;
-extern enum mobjtype_t PuffType;
+extern thread_local struct line_t  *target_line;
+extern thread_local enum mobjtype_t PuffType;
 
 #endif
@@ -216,6 +216,7 @@ public:
   lightfx_t(Map *m, sector_t *sec, lightfx_e type, short maxlight, short minlight = 0, short maxtime = 0, short mintime = 0);
   
   virtual void Think();
+  static  void ThinkBatch(Thinker *const *t, int n); ///< see thinkerbatch_t
 };
 
 // strobe light timings (tics)
@@ -238,6 +239,7 @@ public:
   phasedlight_t(Map *m, sector_t *sec, int base, int index);
   
   virtual void Think();
+  static  void ThinkBatch(Thinker *const *t, int n); ///< see thinkerbatch_t
 };
 
 
@@ -867,6 +869,7 @@ public:
   scroll_t(short type, fixed_t dx, fixed_t dy, sector_t *csec, int aff, bool acc);
   
   virtual void Think();
+  static  void ThinkBatch(Thinker *const *t, int n); ///< see thinkerbatch_t
 };
 
 
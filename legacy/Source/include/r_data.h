@@ -146,6 +146,9 @@ public:
   Texture(const char *name, int lump = -1);
   virtual ~Texture();
 
+  virtual unsigned Size();
+  virtual bool Flush();
+
   /// \name Software renderer
   //@{
   /// True means that texture is available in column_t format using GetMaskedColumn
@@ -230,6 +233,9 @@ protected:
 public:
   TGATexture(const char *name, int lump);
   virtual ~TGATexture();
+
+  virtual unsigned Size();
+  virtual bool Flush();
   virtual byte *GetData();
 };
 
@@ -250,6 +256,9 @@ public:
   PatchTexture(const char *name, int lump);
   virtual ~PatchTexture();
 
+  virtual unsigned Size();
+  virtual bool Flush();
+
   virtual bool Masked() { return true; };
   virtual column_t *GetMaskedColumn(fixed_t col);
   virtual byte *GetData();
@@ -292,6 +301,9 @@ public:
   DoomTexture(const char *name, int lump, const struct maptexture_t *mtex);
   virtual ~DoomTexture();
 
+  virtual unsigned Size();
+  virtual bool Flush();
+
   virtual bool Masked() { return (patchcount == 1); };
   virtual column_t *GetMaskedColumn(fixed_t col);
   virtual byte *GetColumn(fixed_t col);
@@ -310,6 +322,8 @@ protected:
   virtual Texture *Load(const char *name);
 
 public:
+  texture_cache_t() : cache_t<Texture>("textures") {}
+
   /// Creates a Texture with a given name from a given lump.
   Texture *LoadLump(const char *name, int lump);
 };
@@ -385,13 +399,13 @@ public:
   inline bool Masked() { return tex[0].t->Masked(); };
 
   /// Get masked indexed texture column data. if Masked() is false, returns NULL
-  inline column_t *GetMaskedColumn(fixed_t col) { return tex[0].t->GetMaskedColumn(col * tex[0].xscale); }
+  inline column_t *GetMaskedColumn(fixed_t col) { tex[0].t->Touch(); return tex[0].t->GetMaskedColumn(col * tex[0].xscale); }
 
   /// Get unmasked indexed texture column data.
-  inline byte *GetColumn(fixed_t col) { return tex[0].t->GetColumn(col * tex[0].xscale); }
+  inline byte *GetColumn(fixed_t col) { tex[0].t->Touch(); return tex[0].t->GetColumn(col * tex[0].xscale); }
 
   /// Get indexed column-major texture data.
-  inline byte *GetData() { return tex[0].t->GetData(); }
+  inline byte *GetData() { tex[0].t->Touch(); return tex[0].t->GetData(); }
   //@}
 
 public:
@@ -203,9 +203,6 @@ struct line_t
   sector_t *frontsector;
   sector_t *backsector;
 
-  /// if == global validcount, already checked
-  int validcount;
-
   /// Thinker for complex actions
   class Thinker *thinker;
 
@@ -365,6 +362,7 @@ struct sector_t
 
 
   int     validcount;   ///< if == global validcount, already checked
+  Uint32  lastmove;     ///< Map::sector_moves after the latest floor/ceiling move, stale sight results are traced again
 
 
   // lockout machinery for stairbuilding
@@ -413,9 +411,6 @@ public:
   /// Returns the contents of the sector at height z.
   zcheck_t CheckZ(fixed_t z);
 
-  /// Shrinks and chops up the range in by Z-planes in sector, returns low-to-high sorted list of ranges.
-  std::list<range_t> *FindLineOpeningsInRange(const range_t& in);
-
 
   ///  Returns a side_t* given a line number, and the side (0/1) that you want.
   inline side_t *getSide(int line, int side)
@@ -52,7 +52,8 @@ extern fixed_t          centeryfrac;
 extern fixed_t          projection;
 extern fixed_t          projectiony;    //added:02-02-98:aspect ratio test...
 
-extern int              validcount;
+extern thread_local int validcount;
+int NewValidCount();
 
 extern int              linecount;
 extern int              loopcount;
@@ -64,6 +64,8 @@ public:
   sprite_t(const char *name);
   virtual ~sprite_t();
 
+  virtual unsigned Size() { return numframes * sizeof(spriteframe_t); }
+
   Sint32  iname;  ///< sprite name (4 chars) as an int
   int            numframes;
   spriteframe_t *spriteframes;
@@ -76,6 +78,9 @@ class spritecache_t : public cache_t<sprite_t>
 {
 protected:
   virtual sprite_t *Load(const char *name);
+
+public:
+  spritecache_t() : cache_t<sprite_t>("sprites") {}
 };
 
 extern spritecache_t sprites;
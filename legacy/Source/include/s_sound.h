@@ -91,6 +91,8 @@ public:
   sounditem_t(const char *name);
   virtual ~sounditem_t();
 
+  virtual unsigned Size();
+
   unsigned  rate;   ///< sample rate in Hz
   unsigned  depth;  ///< sample size in bytes (1 or 2)
   void     *data;   ///< unconverted data
@@ -72,6 +72,12 @@ public:
 
   /// returns true and passes the asked data if the file can be transferred
   virtual bool GetNetworkInfo(int *size, unsigned char *md5) {return false;};
+  /// returns false if the file has a content digest for GetNetworkInfo which has not yet been computed
+  virtual bool DigestValid() { return true; }
+  /// Computes the content digest. Touches no global state, so it may be called from worker threads.
+  virtual void ComputeDigest() {}
+  /// Returns the size, modification time and inode number of the physical file, or false if there is none.
+  virtual bool GetIdentity(Sint64 *size, Sint64 *mtime, Sint64 *inode) { return false; }
 
   /// returns the number of data items in this file
   int GetNumItems() const { return numitems; }
@@ -84,13 +90,21 @@ public:
 
   /// returns the index of data item 'name', searching from startitem forward, or -1 if not found
   virtual int FindNumForName(const char* name, int startitem = 0);
+  /// Returns true if FindNumForName(name) would accept item i. key is name in uppercase, NUL-padded to 8 bytes.
+  virtual bool MatchItem(int i, const char *name, const Uint32 *key);
   /// Same as above, but matches only the first four chars (in iname), and sets fullname to point to the full name.
   virtual int FindPartialName(Uint32 iname, int startlump, const char **fullname) {return -1;};
 
-  /// Caches the requested item, overriding current tag, returns a pointer to the raw data.
+  /// Caches the requested item, returns a pointer to the raw data.
+  /// The buffer is shared: every call returns the same one until it is freed, which also clears the cache entry.
   void *CacheItem(int item, int tag);
+  /// Returns a pointer to the raw item data inside a memory mapping, or NULL if the item must be read or cached instead.
+  /// The data is in file byte order, and must not be modified or freed.
+  virtual const byte *MapItem(int item) { return NULL; }
   /// Tries to write size bytes of data item item into dest, returns the number of bytes actually written.
   int ReadItem(int item, void *dest, unsigned size, unsigned offset = 0);
+  /// Hint that the given items will be read soon. Returns the number of items that were cached ahead.
+  virtual int Prefetch(const int *items, int n) { return 0; }
   
   virtual int GetItemListFromMemory() const { return numitems; }
 
@@ -128,10 +142,24 @@ public:
 /// \brief ABC for physical files (not directories!)
 class VDataFile : public VFile
 {
+  friend class FileCache;
+
 protected:
   FILE *stream;    ///< associated stream
   int   size;      ///< file size in bytes
-  unsigned char md5sum[16]; ///< MD5 checksum for data integrity checks
+  unsigned char md5sum[16]; ///< MD5 checksum for data integrity checks, computed on demand
+  bool  md5valid;  ///< md5sum has been computed
+  Sint64 mtime;    ///< file modification time and inode number, used as a key in the digest cache
+  Sint64 inode;
+
+  byte *mapping;   ///< read-only memory mapping of the entire file, or NULL
+#ifdef __WIN32__
+  void *maphandle; ///< file mapping object
+#endif
+
+  /// Maps the entire file into memory, unless -nommap was given. Returns true if succesful.
+  bool MapFile();
+  void UnmapFile();
 
 public:
   VDataFile();
@@ -140,6 +168,9 @@ public:
   virtual bool Open(const char *fname);
 
   virtual bool GetNetworkInfo(int *size, unsigned char *md5);
+  virtual bool DigestValid() { return md5valid; }
+  virtual void ComputeDigest();
+  virtual bool GetIdentity(Sint64 *size, Sint64 *mtime, Sint64 *inode);
 
   // query data item properties
   virtual const char *GetItemName(int i) = 0;
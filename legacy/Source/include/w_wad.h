@@ -25,6 +25,7 @@
 
 #include <vector>
 #include <string>
+#include <map>
 
 #include "doomtype.h"
 
@@ -50,11 +51,57 @@ private:
   string datapath;              ///< absolute path for searching files
   vector<class VFile *> vfiles; ///< open virtual files
 
+  /// \name Lump name index
+  /// Open addressing hash table from the uppercase 8-byte lump name to the chain
+  /// of all lumps (in all VFiles) with that name, in lump number order.
+  /// Each VFile has the final word on whether a lump in the chain matches the name.
+  //@{
+  struct lumpslot_t
+  {
+    Uint32 key[2];     ///< uppercase name, NUL-padded
+    int    first, last; ///< chain of index entries, first == -1 means an empty slot
+  };
+
+  vector<lumpslot_t> lumphash; ///< size is a power of two
+  vector<int> lumpnums;  ///< lump number for each index entry
+  vector<int> lumpnext;  ///< next entry with the same name, or -1
+  vector<int> lumpprev;  ///< previous entry with the same name, or -1
+  bool index_valid;      ///< false when vfiles has changed
+
+  unsigned n_lookups, n_found, n_probes, n_chainsteps, n_rebuilds, build_ms; ///< statistics
+  unsigned n_mapped, n_copied;       ///< AcquireLump statistics
+  double   mapped_bytes, copied_bytes;
+
+  void BuildIndex();
+  lumpslot_t *FindSlot(const Uint32 *key);
+  //@}
+
+  /// \name Digest cache
+  /// On-disk cache of the MD5 digests of the VDataFiles, keyed by path, size, mtime and inode,
+  /// so that unchanged files need not be rehashed every time the program is started.
+  //@{
+  struct digest_t
+  {
+    Sint64 size, mtime, inode;
+    byte   md5[16];
+  };
+
+  string digestfile;              ///< cache file name, empty means no cache
+  map<string, digest_t> digests;  ///< from file names to digests
+  bool digests_loaded, digests_dirty;
+
+  void LoadDigests();
+  void SaveDigests();
+  //@}
+
 public:
+  FileCache();
   ~FileCache();
 
   /// Set the default path.
   void SetPath(const char *path);
+  /// Set the digest cache file.
+  void SetDigestCache(const char *filename);
   /// Try to find the given file, return path where found.
   const char *Access(const char *filename);
   /// Open a new VFile, return -1 on error.
@@ -72,6 +119,11 @@ public:
   unsigned int GetNumLumps(int filenum);
   /// Writes miscellaneous info about the VFile into the BitStream.
   void WriteNetInfo(TNL::BitStream &s);
+  /// Computes the missing VFile digests, using the digest cache and hashing the rest in parallel.
+  void UpdateDigests();
+  /// Combined key of all open VFiles in load order, built from the same file names, sizes, mtimes and inodes as the digest cache
+  /// without reading the files. Files living in memory use their content digest. Returns false if some VFile has neither (e.g. a directory).
+  bool GetIdentityKey(byte *md5);
 
   // Search methods return a lump number. Return -1 if nothing is found.
 
@@ -96,15 +148,26 @@ public:
   /// Read size bytes from the lump (starting from the given offset) into dest. Returns the number of bytes actually read.
   int ReadLumpHeader(int lump, void *dest, unsigned size, unsigned offset = 0);
   /// Read the entire lump into memory, allocating the space. Returns a pointer to the buffer.
+  /// Unless add_NUL is set, the buffer is the shared cached copy of the lump, see VFile::CacheItem.
   void *CacheLumpNum(int lump, int tag, bool add_NUL = false);
   /// Read the entire lump into dest without allocating any memory.
   inline int ReadLump(int lump, void *dest) { return ReadLumpHeader(lump, dest, 0); };
   /// Shorthand for caching lumps by name.
   inline void *CacheLumpName(const char* name, int tag) { return CacheLumpNum(GetNumForName(name), tag); };
+
+  /// Read-only access to a lump without copying it, if the VFile is memory mapped.
+  /// Falls back to a private copy otherwise. The data is in file byte order and must not be modified,
+  /// lumps that need in-place conversion must use CacheLumpNum. Every call must be paired with ReleaseLump.
+  const void *AcquireLump(int lump);
+  /// Releases a lump obtained using AcquireLump.
+  void ReleaseLump(int lump, const void *data);
   
   void CacheArchiveFile(VFile* vf);
   Uint16 CacheArchiveFile_Remove();
   Uint8 CacheListIndex(void);
+
+  /// Prints the lump index and mapping statistics.
+  void PrintStats();
 };
 
 
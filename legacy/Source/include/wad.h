@@ -23,6 +23,8 @@
 #ifndef wad_h
 #define wad_h 1
 
+#include <vector>
+
 #include "doomtype.h"
 #include "vfile.h"
 
@@ -54,9 +56,11 @@ public:
   virtual const char *GetItemName(int i);
   virtual int  GetItemSize(int i);
   virtual void ListItems();
+  virtual const byte *MapItem(int lump);
 
   // search
   virtual int FindNumForName(const char* name, int startlump = 0);
+  virtual bool MatchItem(int i, const char *name, const Uint32 *key);
   virtual int FindPartialName(Uint32 iname, int startlump, const char **fullname);
 
   /// process any DeHackEd lumps in this wad
@@ -89,9 +93,12 @@ public:
   virtual const char *GetItemName(int i);
   virtual int  GetItemSize(int i);
   virtual void ListItems();
+  virtual const byte *MapItem(int item);
+  virtual void ComputeDigest();
   
   // search
   virtual int FindNumForName(const char* name, int startlump = 0);
+  virtual bool MatchItem(int i, const char *name, const Uint32 *key);
   virtual int FindPartialName(Uint32 iname, int startlump, const char **fullname);
 
   /// process any DeHackEd lumps in this wad
@@ -134,6 +141,7 @@ public:
 
   /// search
   virtual int FindNumForName(const char* name, int startlump = 0);
+  virtual bool MatchItem(int i, const char *name, const Uint32 *key);
 };
 
 
@@ -174,6 +182,20 @@ class ZipFile : public VDataFile
 protected:
   struct zipdir_t *directory; ///< item directory
 
+  /// \name Central directory index
+  /// Open addressing hash table from item names (ignoring case) to the first item with that name.
+  /// Items with the same name are chained in increasing order.
+  //@{
+  vector<int> namehash; ///< size is a power of two, -1 means an empty slot
+  vector<int> namenext; ///< next item with the same name, or -1
+  void BuildIndex();
+  //@}
+
+  /// Returns a pointer to the (possibly compressed) item data inside the mapping, or NULL.
+  const byte *MapCompressed(int item);
+  /// Inflates a DEFLATEd item into dest, returns true if succesful.
+  bool InflateItem(int item, byte *dest);
+
   virtual int Internal_ReadItem(int item, void *dest, uint32_t size, uint32_t offset = 0);
 
 public:
@@ -190,11 +212,19 @@ public:
   virtual void ListItems();
 
   // search
+  virtual int FindNumForName(const char *name, int startitem = 0);
   //virtual int FindPartialName(Uint32 iname, int startlump, const char **fullname);
+
+  /// Stored (uncompressed) items can be used straight from the mapping.
+  virtual const byte *MapItem(int item);
+  /// Inflates the given items in parallel into the item cache.
+  virtual int Prefetch(const int *items, int n);
   
   /* Marty */
   virtual int  GetItemListFromMemory();
-  
+
+  /// Prints the decompression statistics of all ZipFiles.
+  static void PrintStats();
 };
 
 #endif
@@ -24,6 +24,8 @@
 #define z_cache_h 1
 
 #include <string.h>
+#include <algorithm>
+#include <vector>
 #include "doomdef.h"
 #include "dictionary.h"
 
@@ -31,13 +33,17 @@
 /// \brief BC for cache items
 class cacheitem_t
 {
+  template<typename T> friend class cache_t;
 protected:
 #define CACHE_NAME_LEN 63 // was 8
   char  name[CACHE_NAME_LEN+1]; ///< name of the item, NUL-terminated
   int   usefulness; ///< how many times has it been used?
   int   refcount;   ///< reference count, number of current users
+  unsigned lastuse; ///< cache clock at the latest use, for LRU eviction
 
 public:
+  static unsigned clock; ///< advanced by cachebase_t::Maintain() once per rendered frame
+
   cacheitem_t(const char *name);
   virtual ~cacheitem_t() {}; // TODO unnecessary virtualization???
 
@@ -50,6 +56,7 @@ public:
   inline bool AddRef()
   {
     refcount++;
+    lastuse = clock;
     if (usefulness < 0)
       {
 	usefulness--;
@@ -62,9 +69,30 @@ public:
       }
   }
 
+  /// Marks the item used without taking a reference.
+  inline void Touch() { lastuse = clock; }
+
   /// releases the item by decrementing the refcount
   bool Release();
 
+  /// True if someone holds a reference to the item.
+  inline bool InUse() const { return refcount > 0; }
+
+  /// Is the item a link to the default item?
+  inline bool IsLink() const { return usefulness < 0; }
+
+  /// \name Memory budget
+  /// A cache over its budget first tries to Flush() its least recently used items.
+  /// Items that cannot regenerate their payload are deleted instead, if unused.
+  //@{
+  /// Number of bytes of payload the item currently holds.
+  virtual unsigned Size() { return 0; }
+
+  /// Frees the payload but keeps the item itself, the payload is regenerated on demand.
+  /// Returns false if the item does not support this.
+  virtual bool Flush() { return false; }
+  //@}
+
   /// Deletes the cacheitem (and returns true) if refcount is zero.
   bool FreeIfUnused();
 
@@ -102,6 +130,20 @@ public:
       s->second->Print();
   }
 
+  /// Returns the total payload of the items in bytes. If v is given, the items holding a payload are appended to it.
+  unsigned Payload(std::vector<T*> *v)
+  {
+    unsigned total = 0;
+    for (typename parent::dict_iter_t s = parent::dict_map.begin(); s != parent::dict_map.end(); s++)
+      {
+	unsigned size = s->second->Size();
+	total += size;
+	if (size && v)
+	  v->push_back(s->second);
+      }
+    return total;
+  }
+
   /// Deletes unused items (refcount == 0)
   int  Cleanup()
   {
@@ -124,13 +166,60 @@ public:
 };
 
 
+/// \brief Non-template base class for caches, handles the memory budgets and statistics.
+///
+/// All caches are kept in a list so they can be managed from the console.
+class cachebase_t
+{
+protected:
+  const char *cname;  ///< name of the cache, used in console commands
+  unsigned budget;    ///< maximum payload in bytes, zero means unlimited
+  unsigned hits, misses;      ///< Get() statistics
+  unsigned evictions;         ///< number of items flushed or deleted
+  unsigned evicted_bytes;     ///< payload freed by evictions
+  unsigned peak;              ///< largest payload seen by Enforce()
+
+  cachebase_t *next;          ///< all the caches are kept in a list
+  static cachebase_t *caches;
+
+public:
+  cachebase_t(const char *name);
+  virtual ~cachebase_t() {}
+
+  inline const char *GetName() const { return cname; }
+
+  /// Sets the memory budget in bytes, zero means unlimited. Enforced by the next Maintain().
+  inline void SetBudget(unsigned b) { budget = b; }
+  inline unsigned GetBudget() const { return budget; }
+
+  /// Returns the number of payload bytes currently held by the cache items.
+  virtual unsigned Usage() = 0;
+
+  /// Evicts least recently used items until the cache is within its budget. Returns the number of items evicted.
+  virtual int Enforce() = 0;
+
+  /// Prints the statistics of the cache.
+  void PrintStats();
+
+  /// Finds a cache by name.
+  static cachebase_t *FindCache(const char *name);
+
+  /// Enforces the budgets of all caches and advances the cache clock. Must be called between frames.
+  static void Maintain();
+
+  /// Prints the statistics of all caches.
+  static void PrintAll();
+};
+
+
+
 /// \brief Template for different types of simple caches.
 ///
 /// Data used through a cache_t must not be used anywhere
 /// else, because Z_Free and Z_ChangeTag will cause problems.
 /// T must be descendant of cacheitem_t.
 template<typename T>
-class cache_t
+class cache_t : public cachebase_t
 {
 protected:
   cachesource_t<T> source; ///< a simple cache has only one source
@@ -139,9 +228,17 @@ protected:
   /// Creates a new cacheitem_t, does the actual loading and conversion of the data during a Get() operation.
   virtual T *Load(const char *name) = 0;
 
+  /// Orders eviction candidates, least recently and least often used first.
+  static bool EvictOrder(T *a, T *b)
+  {
+    if (a->lastuse != b->lastuse)
+      return a->lastuse < b->lastuse;
+    return a->usefulness < b->usefulness;
+  }
+
 public:
   /// cache constructor
-  cache_t() { default_item = NULL; }
+  cache_t(const char *name) : cachebase_t(name) { default_item = NULL; }
 
   /// cache destructor
   virtual ~cache_t()
@@ -172,8 +269,12 @@ public:
 
     T *p = source.Find(name);
     if (!p)
-      return NULL;
+      {
+	misses++;
+	return NULL;
+      }
 
+    hits++;
     if (p->AddRef())
       {
 	// a "link" to default_item
@@ -198,9 +299,12 @@ public:
     else
       {
 	p = source.Find(name);
-	if (!p)
+	if (p)
+	  hits++;
+	else
 	  {
 	    // Not found in source.
+	    misses++;
 	    p = Load(name);
 	    if (!p)
 	      {
@@ -255,6 +359,54 @@ public:
 
   /// Removes unused data items from cache
   inline int Cleanup() { return source.Cleanup(); };
+
+  virtual unsigned Usage() { return source.Payload(NULL); }
+
+  virtual int Enforce()
+  {
+    if (!budget)
+      return 0;
+
+    std::vector<T*> items;
+    unsigned usage = source.Payload(&items);
+
+    if (usage > peak)
+      peak = usage;
+
+    if (usage <= budget)
+      return 0;
+
+    // evict a bit more than necessary so we won't be back here on the next frame
+    unsigned target = budget - budget/8;
+    std::sort(items.begin(), items.end(), EvictOrder);
+
+    int n = items.size();
+    int k = 0;
+    for (int i = 0; i < n && usage > target; i++)
+      {
+	T *p = items[i];
+	if (p->lastuse == cacheitem_t::clock)
+	  break; // the rest were used during this frame, the budget is simply too small
+
+	unsigned size = p->Size();
+	if (p->Flush())
+	  size -= p->Size();
+	else if (!p->InUse())
+	  {
+	    source.Remove(p->GetName());
+	    delete p;
+	  }
+	else
+	  continue;
+
+	usage -= size;
+	evicted_bytes += size;
+	evictions++;
+	k++;
+      }
+
+    return k;
+  }
 };
 
 
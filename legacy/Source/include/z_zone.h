@@ -55,11 +55,18 @@ void Z_Init();
 /// Number of bytes allocated for given tag type.
 unsigned Z_TagUsage(unsigned tagnum);
 
+/// High-water mark of Z_TagUsage since startup or the latest profiler reset.
+unsigned Z_TagPeak(unsigned tagnum);
+
 /// Tag used by ptr. ptr MUST be allocated using Z_Malloc.
 int Z_GetTag(void *ptr);
 
-/// Allocate memory.
-void *Z_Malloc(int size, int tag, void **user);
+/// Size of the block pointed to by ptr. ptr MUST be allocated using Z_Malloc.
+int Z_GetSize(void *ptr);
+
+/// Allocate memory. The call site is recorded for the allocation profiler.
+void *Z_Malloc2(int size, int tag, void **user, const char *file, int line);
+#define Z_Malloc(s,t,u) Z_Malloc2((s),(t),(u),__FILE__,__LINE__)
 #define Z_MallocAlign(s,t,p,a) Z_Malloc((s),(t),(p))
 #define ZZ_Alloc(x) Z_Malloc((x), PU_STATIC, NULL)
 
@@ -69,4 +76,105 @@ void Z_Free(void *ptr);
 /// Duplicate a string into newly allocated memory.
 char *Z_Strdup(const char *s, int tag, void **user);
 
+
+/// \brief Memory region for allocations that share a common lifetime.
+///
+/// A region hands out memory from large chunks using a bump pointer.
+/// While it is bound using Z_SetRegion(), all PU_LEVEL and PU_LEVSPEC
+/// allocations are served from it. Blocks can still be Z_Free'd individually
+/// (which only does the bookkeeping), but the memory is returned to the system
+/// all at once when the region is destroyed. Owner pointers of blocks still alive
+/// at that point are cleared, just like Z_Free would do.
+class memregion_t
+{
+  friend void Z_Free(void *ptr);
+
+private:
+  struct chunk_t
+  {
+    chunk_t *next;
+    unsigned size; ///< usable bytes following the header
+    unsigned used; ///< bytes handed out
+  };
+
+  struct owned_t
+  {
+    struct mem_extra_t *block;
+    owned_t *next;
+  };
+
+  int       index;     ///< position in the region table, stored in the block headers
+  unsigned  chunksize; ///< size of a normal chunk
+  chunk_t  *chunks;    ///< newest chunk first
+  owned_t  *owned;     ///< blocks with owner pointers, and all blocks while profiling
+  unsigned  usage[PU_NUMTAGS]; ///< bytes currently allocated per tag
+
+  void *Bump(unsigned size);
+  void  Free(struct mem_extra_t *p);
+
+public:
+  memregion_t(unsigned chunksize = 1 << 20);
+  ~memregion_t(); ///< releases all the memory in the region
+
+  /// Allocates memory from the region, like Z_Malloc.
+  void *Malloc(int size, int tag, void **user);
+
+  /// Total number of bytes obtained from the system.
+  unsigned Reserved() const;
+};
+
+/// Binds a memory region for PU_LEVEL and PU_LEVSPEC allocations (NULL unbinds). Returns the previously bound region.
+memregion_t *Z_SetRegion(memregion_t *r);
+
+
+/// \brief Slab allocator for small objects of many different sizes.
+///
+/// Requests are rounded up to size classes, each served from slabs of its own.
+/// Freed slots go to an intrusive free list of their class and are reused first,
+/// so objects that are constantly created and destroyed do not touch the heap.
+/// The slabs are kept for the entire execution, so the pool never shrinks below its high-water mark.
+/// The size of the object must also be given when freeing it.
+/// The tag statistics of the zone are charged with the slabs and the large objects, i.e. what the pool holds.
+/// The free lists are not thread safe. The pool may only be used by the main thread, or by a job holding
+/// a biglock_t such as the maplock of parallel Map ticking, which is checked on every call.
+class mempool_t
+{
+private:
+#define POOL_GRANULARITY 16   ///< size classes are multiples of this
+#define POOL_MAXSIZE     2048 ///< larger objects are malloc'ed directly
+#define POOL_SLABSIZE    (64 << 10)
+
+  struct slot_t
+  {
+    slot_t *next;
+  };
+
+  struct sizeclass_t
+  {
+    slot_t  *freelist; ///< free slots
+    unsigned slabs;    ///< number of slabs
+    unsigned used;     ///< slots in use
+  };
+
+  const char *name;
+  int         tag;  ///< memory tag for the statistics
+  sizeclass_t classes[POOL_MAXSIZE / POOL_GRANULARITY];
+  unsigned    large; ///< bytes in objects too large for the slabs
+
+  mempool_t  *next; ///< all the pools are kept in a list
+
+public:
+  mempool_t(const char *name, int tag);
+
+  /// Returns memory for an object of the given size.
+  void *Alloc(size_t size);
+  /// Returns the object to its size class.
+  void  Free(void *p, size_t size);
+
+  /// Prints the pool statistics to the console.
+  void Print() const;
+  /// Prints the statistics of all the pools.
+  static void PrintAll();
+};
+
 #endif
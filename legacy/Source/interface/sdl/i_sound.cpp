@@ -44,6 +44,7 @@
 #include "m_argv.h"
 #include "m_misc.h"
 #include "w_wad.h"
+#include "m_profile.h"
 
 #include "s_sound.h"
 #include "sounds.h"
@@ -251,6 +252,8 @@ bool I_SoundIsPlaying(int handle)
 //
 static void I_UpdateSound_sdl(void *unused, Uint8 *stream, int len)
 {
+  PROFILE_ZONE("I_UpdateSound_sdl");
+
   if (nosound)
     return;
 
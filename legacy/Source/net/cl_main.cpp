@@ -45,6 +45,7 @@
 #include "sounds.h"
 #include "r_main.h"
 #include "m_misc.h"
+#include "m_profile.h"
 #include "w_wad.h"
 #include "v_video.h"
 
@@ -161,10 +162,16 @@ void CL_Init()
   CONS_Printf("\n============ CL_Init ============\n");
 
   // set the video mode, graphics scaling properties, load palette
-  vid.Startup();
+  {
+    stagetimer_t s("video");
+    vid.Startup();
+  }
 
   // init renderer
-  R_Init();
+  {
+    stagetimer_t s("renderer");
+    R_Init();
+  }
 
   font_t::Init();
 
@@ -181,11 +188,17 @@ void CL_Init()
   automap.Startup();
 
   // set up sound and music
-  S.Startup();
+  {
+    stagetimer_t s("sound");
+    S.Startup();
+  }
 
   // read the basic legacy.wad sound script lumps
-  S_Read_SNDINFO(fc.FindNumForNameFile("SNDINFO", 0));
-  S_Read_SNDSEQ(fc.FindNumForNameFile("SNDSEQ", 0));
+  {
+    stagetimer_t s("SNDINFO, SNDSEQ");
+    S_Read_SNDINFO(fc.FindNumForNameFile("SNDINFO", 0));
+    S_Read_SNDSEQ(fc.FindNumForNameFile("SNDSEQ", 0));
+  }
 
   COM.AddCommand("player", Command_Player_f);
   COM.AddCommand("setcontrol", Command_Setcontrol_f);
@@ -38,6 +38,7 @@
 
 
 #include "m_misc.h"
+#include "m_profile.h"
 #include "w_wad.h"
 #include "vfile.h"
 
@@ -447,6 +448,8 @@ void LNetInterface::SV_Reset()
 
 void LNetInterface::Update()
 {
+  PROFILE_ZONE("LNetInterface::Update");
+
   nowtime = I_GetTime();
 
   switch (netstate)
@@ -498,6 +501,8 @@ class NetFileInfo
 
 void FileCache::WriteNetInfo(BitStream &s)
 {
+  UpdateDigests(); // all at once, in parallel
+
   S32 n = vfiles.size();
   s.write(n); // number of files
 
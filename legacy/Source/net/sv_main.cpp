@@ -121,6 +121,7 @@ Have polymorphed class GameType which creates these into GameInfo containers
 #include "sounds.h"
 
 #include "w_wad.h"
+#include "m_profile.h"
 #include "z_zone.h"
 
 
@@ -190,6 +191,9 @@ consvar_t cv_fastmonsters = {"fastmonsters", "0", CV_NETVAR | CV_CALL, CV_OnOff,
 consvar_t cv_solidcorpse  = {"solidcorpse", "0", CV_NETVAR, CV_OnOff};
 consvar_t cv_voodoodolls  = {"voodoodolls", "1", CV_NETVAR, CV_OnOff};
 consvar_t cv_infighting  = {"infighting", "1", CV_NETVAR, CV_OnOff};
+consvar_t cv_parallelmaps = {"parallelmaps", "0", CV_SAVE, CV_OnOff}; // single player only
+consvar_t cv_batchsight   = {"batchsight", "1", CV_SAVE, CV_OnOff};
+consvar_t cv_dormantmonsters = {"dormantmonsters", "0", CV_SAVE, CV_OnOff}; // single player only
 
 
 void TeamPlay_OnChange()
@@ -297,6 +301,8 @@ void ExitMode_OnChange()
 
 void GameInfo::TryRunTics(tic_t elapsed)
 {
+  PROFILE_ZONE("TryRunTics");
+
   extern  bool singletics;
 
   // max time step
@@ -611,6 +617,17 @@ void Command_CheatGod_f();
 void Command_CheatGimme_f();
 
 void Command_Meminfo_f();
+void Command_MemProf_f();
+void Command_LumpInfo_f();
+void Command_ZipInfo_f();
+void Command_StartupInfo_f();
+void Command_ThinkerInfo_f();
+void Command_SightStats_f();
+void Command_BenchSim_f();
+void Command_BenchTrace_f();
+void Command_Profile_f();
+void Command_CacheInfo_f();
+void Command_CacheBudget_f();
 
 void Command_RunACS_f();
 
@@ -663,6 +680,17 @@ void SV_Init()
   // informational commands
   COM.AddCommand("version", Command_Version_f);
   COM.AddCommand("meminfo", Command_Meminfo_f);
+  COM.AddCommand("memprof", Command_MemProf_f);
+  COM.AddCommand("lumpinfo", Command_LumpInfo_f);
+  COM.AddCommand("zipinfo", Command_ZipInfo_f);
+  COM.AddCommand("startupinfo", Command_StartupInfo_f);
+  COM.AddCommand("thinkerinfo", Command_ThinkerInfo_f);
+  COM.AddCommand("sightstats", Command_SightStats_f);
+  COM.AddCommand("benchsim", Command_BenchSim_f);
+  COM.AddCommand("benchtrace", Command_BenchTrace_f);
+  COM.AddCommand("profile", Command_Profile_f);
+  COM.AddCommand("cacheinfo", Command_CacheInfo_f);
+  COM.AddCommand("cache_budget", Command_CacheBudget_f);
   COM.AddCommand("gameinfo", Command_GameInfo_f);
   COM.AddCommand("mapinfo", Command_MapInfo_f);
   COM.AddCommand("players", Command_Players_f);
@@ -750,6 +778,9 @@ void SV_Init()
   cv_solidcorpse.Reg();
   cv_voodoodolls.Reg();
   cv_infighting.Reg();
+  cv_parallelmaps.Reg();
+  cv_batchsight.Reg();
+  cv_dormantmonsters.Reg();
 
   cv_playdemospeed.Reg();
   cv_netstat.Reg();
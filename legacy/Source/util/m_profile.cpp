@@ -0,0 +1,277 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Scoped hot path profiler and startup stage timing.
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "doomdef.h"
+#include "command.h"
+#include "m_profile.h"
+
+using namespace std;
+
+/// Zones kept per thread, older ones are overwritten.
+#define PROFILE_BUFSIZE (1 << 16)
+
+
+/// One recorded zone.
+struct profevent_t
+{
+  const char *name;
+  double start, dur; ///< in microseconds since profiler_t::t0
+};
+
+/// Ring buffer of one thread. Only the owner thread writes into it.
+struct profbuffer_t
+{
+  int tid;
+  atomic<unsigned> count; ///< zones recorded during this capture
+  profevent_t events[PROFILE_BUFSIZE];
+};
+
+
+atomic<bool> profiler_t::capturing(false);
+profiler_t::clock::time_point profiler_t::t0;
+
+static mutex buffers_lock;
+static vector<profbuffer_t *> buffers; ///< one for each thread that has ever recorded a zone, never freed
+static thread_local profbuffer_t *mybuffer = NULL;
+static int main_tid = 0; ///< thread that started the capture
+
+
+/// Returns the buffer of the calling thread, creating it if necessary.
+static profbuffer_t *GetBuffer()
+{
+  profbuffer_t *b = mybuffer;
+  if (!b)
+    {
+      b = mybuffer = new profbuffer_t;
+      b->count = 0;
+
+      lock_guard<mutex> l(buffers_lock);
+      b->tid = buffers.size();
+      buffers.push_back(b);
+    }
+  return b;
+}
+
+
+void profiler_t::Record(const char *name, clock::time_point start, clock::time_point end)
+{
+  profbuffer_t *b = GetBuffer();
+  unsigned n = b->count.load(memory_order_relaxed);
+  profevent_t &e = b->events[n % PROFILE_BUFSIZE];
+  e.name = name;
+  e.start = chrono::duration<double, micro>(start - t0).count();
+  e.dur = chrono::duration<double, micro>(end - start).count();
+  b->count.store(n + 1, memory_order_release);
+}
+
+
+void profiler_t::Start()
+{
+  capturing = false;
+  main_tid = GetBuffer()->tid;
+  {
+    lock_guard<mutex> l(buffers_lock);
+    for (unsigned i = 0; i < buffers.size(); i++)
+      buffers[i]->count = 0;
+  }
+
+  t0 = clock::now();
+  capturing.store(true, memory_order_release);
+}
+
+
+struct zonestats_t
+{
+  unsigned calls;
+  double   total;
+};
+
+static bool CompareTotal(const pair<const char *, zonestats_t> &a, const pair<const char *, zonestats_t> &b)
+{
+  return a.second.total > b.second.total;
+}
+
+
+void profiler_t::Stop(const char *fname)
+{
+  capturing = false;
+  double length = chrono::duration<double, milli>(clock::now() - t0).count();
+
+  FILE *f = fopen(fname, "wb");
+  if (!f)
+    {
+      CONS_Printf("Could not open '%s' for writing.\n", fname);
+      return;
+    }
+
+  lock_guard<mutex> l(buffers_lock);
+
+  // zone totals, by name (the names are literals, so pointers will do)
+  map<const char *, zonestats_t> stats;
+  unsigned written = 0, dropped = 0;
+
+  fprintf(f, "{\"traceEvents\":[\n");
+  for (unsigned i = 0; i < buffers.size(); i++)
+    {
+      profbuffer_t *b = buffers[i];
+      fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s %d\"}},\n",
+	      b->tid, b->tid == main_tid ? "main" : "thread", b->tid);
+
+      // Zones that were begun before Stop may still be finishing, so only the ones already there are read,
+      // and the oldest slots, which such zones would overwrite, are skipped if the buffer has wrapped.
+      unsigned n = b->count.load(memory_order_acquire);
+      unsigned first = 0;
+      if (n > PROFILE_BUFSIZE - 16)
+	{
+	  first = n - (PROFILE_BUFSIZE - 16);
+	  dropped += first;
+	}
+
+      for (unsigned k = first; k < n; k++)
+	{
+	  profevent_t &e = b->events[k % PROFILE_BUFSIZE];
+	  fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+		  e.name, b->tid, e.start, e.dur);
+	  zonestats_t &z = stats[e.name];
+	  z.calls++;
+	  z.total += e.dur;
+	  written++;
+	}
+    }
+  fprintf(f, "{}]}\n"); // the empty object absorbs the last comma
+  fclose(f);
+
+  CONS_Printf("%u zones in %.1f ms written to %s", written, length, fname);
+  if (dropped)
+    CONS_Printf(", %u oldest ones dropped", dropped);
+  CONS_Printf("\n");
+
+  vector<pair<const char *, zonestats_t> > sorted(stats.begin(), stats.end());
+  sort(sorted.begin(), sorted.end(), CompareTotal);
+
+  CONS_Printf("%-24s %8s %10s %9s\n", "zone", "calls", "total ms", "mean ms");
+  for (unsigned i = 0; i < sorted.size() && i < 16; i++)
+    {
+      zonestats_t &z = sorted[i].second;
+      CONS_Printf("%-24s %8u %10.2f %9.3f\n", sorted[i].first, z.calls, z.total / 1000, z.total / 1000 / z.calls);
+    }
+}
+
+
+
+/// profile start | stop [file]
+void Command_Profile_f()
+{
+  if (COM.Argc() >= 2 && !strcasecmp(COM.Argv(1), "start"))
+    {
+      profiler_t::Start();
+      CONS_Printf("Profiling started.\n");
+      return;
+    }
+
+  if (COM.Argc() >= 2 && !strcasecmp(COM.Argv(1), "stop"))
+    {
+      if (!profiler_t::capturing)
+	{
+	  CONS_Printf("Not profiling.\n");
+	  return;
+	}
+
+      profiler_t::Stop(COM.Argc() >= 3 ? COM.Argv(2) : "profile.json");
+      return;
+    }
+
+  CONS_Printf("Usage: profile start | stop [file]: capture a Chrome trace of the instrumented zones.\n");
+}
+
+
+
+//=========================================================================
+//                        Startup stage timing
+//=========================================================================
+
+vector<startuptimes_t::stage_t> startuptimes_t::stages;
+bool   startuptimes_t::recording = false;
+int    startuptimes_t::depth = 0;
+double startuptimes_t::total = 0;
+profiler_t::clock::time_point startuptimes_t::t0;
+
+
+double startuptimes_t::Now()
+{
+  return chrono::duration<double, milli>(profiler_t::clock::now() - t0).count();
+}
+
+
+void startuptimes_t::Start()
+{
+  stages.clear();
+  depth = 0;
+  t0 = profiler_t::clock::now();
+  recording = true;
+}
+
+
+void startuptimes_t::Stop()
+{
+  total = Now();
+  recording = false;
+}
+
+
+int startuptimes_t::Begin(const char *name)
+{
+  if (!recording)
+    return -1;
+
+  stage_t s;
+  s.name = name;
+  s.depth = depth++;
+  s.start = s.end = Now();
+  stages.push_back(s);
+  return stages.size() - 1;
+}
+
+
+void startuptimes_t::End(int s)
+{
+  if (s < 0 || !recording)
+    return;
+
+  stages[s].end = Now();
+  depth--;
+}
+
+
+void startuptimes_t::PrintReport()
+{
+  CONS_Printf("\2  start   time  stage\n");
+  for (unsigned i = 0; i < stages.size(); i++)
+    CONS_Printf("%7.1f %6.1f  %*s%s\n", stages[i].start, stages[i].end - stages[i].start, 2*stages[i].depth, "", stages[i].name);
+
+  CONS_Printf("total %.1f ms\n", total);
+}
@@ -61,12 +61,15 @@ byte rndtable[256] =
 static byte     rndindex = 0;
 static byte     prndindex = 0;
 
+/// P_Random state used by this thread, see P_SetRandSource.
+static thread_local byte *prnd = &prndindex;
+
 #ifndef DEBUGRANDOM
 
 // P_Random is used throughout all the p_xxx game code.
 byte P_Random()
 {
-  return rndtable[++prndindex];
+  return rndtable[++*prnd];
 }
 
 // lot of code used P_Random()-P_Random() since C don't define 
@@ -83,15 +86,15 @@ int P_SignedRandom()
 byte P_Random2(char *a,int b)
 {
     CONS_Printf("P_Random at : %sp %d\n",a,b);
-    return rndtable[++prndindex];
+    return rndtable[++*prnd];
 }
 
 int P_SignedRandom2(char *a,int b)
 {
     int r;
     CONS_Printf("P_SignedRandom at : %sp %d\n",a,b);
-    r = rndtable[++prndindex];
-    return r-rndtable[++prndindex];
+    r = rndtable[++*prnd];
+    return r-rndtable[++*prnd];
 }
 
 #endif
@@ -118,6 +121,14 @@ void P_SetRandIndex(byte rindex)
   prndindex = rindex;
 }
 
+// maps ticked in parallel
+byte *P_SetRandSource(byte *rindex)
+{
+  byte *old = prnd;
+  prnd = rindex ? rindex : &prndindex;
+  return old;
+}
+
 
 
 float RandomUniform()
@@ -0,0 +1,186 @@
+// Emacs style mode select   -*- C++ -*-
+//-----------------------------------------------------------------------------
+//
+// Copyright (C) 2026 by DooM Legacy Team.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+//-----------------------------------------------------------------------------
+
+/// \file
+/// \brief Worker thread pool.
+
+#include <stdlib.h>
+
+#include "doomdef.h"
+#include "m_threads.h"
+#include "m_profile.h"
+#include "m_argv.h"
+
+using namespace std;
+
+#define MAX_WORKERS 32
+
+WorkerPool workers;
+
+thread_local biglock_t *biglock_t::held = NULL;
+thread_local int        biglock_t::serial = 0;
+thread_local int        biglock_t::jobs = 0;
+
+
+WorkerPool::WorkerPool()
+{
+  started = quit = false;
+}
+
+WorkerPool::~WorkerPool()
+{
+  Shutdown();
+}
+
+
+void WorkerPool::Start()
+{
+  started = true;
+
+  int n = int(thread::hardware_concurrency()) - 1;
+  if (M_CheckParm("-threads") && M_IsNextParm())
+    n = atoi(M_GetNextParm());
+
+  if (n < 0)
+    n = 0;
+  else if (n > MAX_WORKERS)
+    n = MAX_WORKERS;
+
+  for (int i = 0; i < n; i++)
+    threads.push_back(thread(&WorkerPool::Worker, this));
+}
+
+
+int WorkerPool::NumThreads()
+{
+  unique_lock<mutex> l(lock);
+  if (!started)
+    Start();
+
+  return threads.size();
+}
+
+
+void WorkerPool::RunJob(unique_lock<mutex> &l, deque<job_t>::iterator i)
+{
+  job_t j = *i;
+  queue.erase(i);
+
+  l.unlock();
+  {
+    PROFILE_ZONE("job");
+    biglock_t::jobs++;
+    j.func();
+    biglock_t::jobs--;
+  }
+  l.lock();
+
+  if (--j.group->pending == 0)
+    done_cv.notify_all();
+}
+
+
+void WorkerPool::Worker()
+{
+  unique_lock<mutex> l(lock);
+  while (true)
+    {
+      while (queue.empty() && !quit)
+	work_cv.wait(l);
+
+      if (quit)
+	return;
+
+      RunJob(l, queue.begin());
+    }
+}
+
+
+void WorkerPool::Submit(jobgroup_t &g, const function<void()> &job)
+{
+  unique_lock<mutex> l(lock);
+  if (!started)
+    Start();
+
+  job_t j;
+  j.func = job;
+  j.group = &g;
+  queue.push_back(j);
+  g.pending++;
+
+  work_cv.notify_one();
+}
+
+
+void WorkerPool::Wait(jobgroup_t &g)
+{
+  unique_lock<mutex> l(lock);
+  while (g.pending > 0)
+    {
+      // Help out with the jobs of this group instead of just sleeping.
+      // Other jobs are left alone, the caller may be in the middle of a tic.
+      deque<job_t>::iterator i;
+      for (i = queue.begin(); i != queue.end() && i->group != &g; i++)
+	;
+
+      if (i != queue.end())
+	RunJob(l, i);
+      else
+	done_cv.wait(l);
+    }
+}
+
+
+void WorkerPool::ParallelFor(int n, const function<void(int)> &func)
+{
+  if (n <= 0)
+    return;
+
+  // a few chunks per thread keeps everyone busy even if the items differ in cost
+  int chunks = (NumThreads() + 1) * 4;
+  if (chunks > n)
+    chunks = n;
+
+  jobgroup_t g;
+  for (int c = 0; c < chunks; c++)
+    {
+      int begin = (long long)n * c / chunks;
+      int end = (long long)n * (c+1) / chunks;
+      Submit(g, [&func, begin, end]() {
+	  for (int i = begin; i < end; i++)
+	    func(i);
+	});
+    }
+
+  Wait(g);
+}
+
+
+void WorkerPool::Shutdown()
+{
+  {
+    unique_lock<mutex> l(lock);
+    quit = true;
+    work_cv.notify_all();
+  }
+
+  for (unsigned i = 0; i < threads.size(); i++)
+    threads[i].join();
+
+  threads.clear();
+}
+
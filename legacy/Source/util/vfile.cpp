@@ -21,7 +21,15 @@
 #include <sys/stat.h>
 #include <dirent.h>
 
+#ifdef __WIN32__
+# include <windows.h>
+# include <io.h>
+#else
+# include <sys/mman.h>
+#endif
+
 #include "doomdef.h"
+#include "m_argv.h"
 #include "md5.h"
 #include "vfile.h"
 #include "z_zone.h"
@@ -76,6 +84,12 @@ int VFile::FindNumForName(const char* name, int startitem)
   return -1;
 }
 
+
+bool VFile::MatchItem(int i, const char *name, const Uint32 *key)
+{
+  return !strcmp(GetItemName(i), name);
+}
+
 /* Marty: Code änderung am Ende des Source
 void *VFile::CacheItem(int item, int tag)
 {
@@ -261,10 +275,19 @@ VDataFile::VDataFile()
 {
   stream = NULL;
   size = 0;
+  md5valid = false;
+  mtime = 0;
+  inode = 0;
+  mapping = NULL;
+#ifdef __WIN32__
+  maphandle = NULL;
+#endif
 }
 
 VDataFile::~VDataFile()
 {
+  UnmapFile();
+
   if (stream)
     {
       fclose(stream);
@@ -293,16 +316,97 @@ bool VDataFile::Open(const char *fname)
     }
 
   size = tempstat.st_size;
+  mtime = tempstat.st_mtime;
+  inode = tempstat.st_ino;
+
+  // md5sum is only needed by the network code, see FileCache::UpdateDigests
+  return true;
+}
+
+
+bool VDataFile::MapFile()
+{
+  if (!stream || size <= 0 || M_CheckParm("-nommap"))
+    return false;
+
+#ifdef __WIN32__
+  HANDLE f = reinterpret_cast<HANDLE>(_get_osfhandle(fileno(stream)));
+  HANDLE h = CreateFileMapping(f, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (!h)
+    return false;
+
+  mapping = static_cast<byte*>(MapViewOfFile(h, FILE_MAP_READ, 0, 0, 0));
+  if (!mapping)
+    {
+      CloseHandle(h);
+      return false;
+    }
+  maphandle = h;
+#else
+  void *m = mmap(NULL, size, PROT_READ, MAP_SHARED, fileno(stream), 0);
+  if (m == MAP_FAILED)
+    return false;
+
+  mapping = static_cast<byte*>(m);
+#endif
+  return true;
+}
+
+
+void VDataFile::UnmapFile()
+{
+  if (!mapping)
+    return;
+
+#ifdef __WIN32__
+  UnmapViewOfFile(mapping);
+  CloseHandle(static_cast<HANDLE>(maphandle));
+  maphandle = NULL;
+#else
+  munmap(mapping, size);
+#endif
+  mapping = NULL;
+}
+
+
+void VDataFile::ComputeDigest()
+{
+  if (mapping)
+    {
+      md5_buffer(reinterpret_cast<const char*>(mapping), size, md5sum);
+      return;
+    }
 
-  // generate md5sum 
-  md5_stream(stream, md5sum);
+  // use a stream of our own, this may run in a worker thread
+  FILE *f = fopen(filename.c_str(), "rb");
+  if (!f || md5_stream(f, md5sum))
+    memset(md5sum, 0, sizeof(md5sum));
 
+  if (f)
+    fclose(f);
+}
+
+
+bool VDataFile::GetIdentity(Sint64 *s, Sint64 *mt, Sint64 *in)
+{
+  if (!stream)
+    return false; // lives in memory
+
+  *s = size;
+  *mt = mtime;
+  *in = inode;
   return true;
 }
 
 
 bool VDataFile::GetNetworkInfo(int *s, unsigned char *md5)
 {
+  if (!md5valid)
+    {
+      ComputeDigest();
+      md5valid = true;
+    }
+
   *s = size;
   for (int i=0; i<16; i++)
     md5[i] = md5sum[i];
@@ -40,6 +40,8 @@
 #include "w_wad.h" // FileCache Class
 #include "z_zone.h"
 #include "m_misc.h"
+#include "m_threads.h"
+#include "md5.h"
 
 
 //====================================================================
@@ -51,6 +53,16 @@
 FileCache fc;
 
 
+FileCache::FileCache()
+{
+  index_valid = false;
+  n_lookups = n_found = n_probes = n_chainsteps = n_rebuilds = build_ms = 0;
+  n_mapped = n_copied = 0;
+  mapped_bytes = copied_bytes = 0;
+  digests_loaded = digests_dirty = false;
+}
+
+
 // destroys (closes) all open VFiles
 // If not done on a Mac then open wad files
 // can prevent removable media they are on from
@@ -62,6 +74,7 @@ FileCache::~FileCache()
       delete vfiles[i];
     }
   vfiles.clear();
+  index_valid = false;
   return;
 }
 
@@ -77,6 +90,13 @@ void FileCache::SetPath(const char *p)
 }
 
 
+void FileCache::SetDigestCache(const char *filename)
+{
+  digestfile = filename;
+  digests_loaded = false;
+}
+
+
 // Not like libc access(). If file exists, returns the path+filename where it was found, otherwise NULL.
 const char *FileCache::Access(const char *f)
 { 
@@ -397,6 +417,7 @@ int FileCache::AddFile(const char *fname, bool silent)
   if (ok)
   {
     vfiles.push_back(vf); 
+    index_valid = false;
     nfiles = CacheArchiveFile_Remove();
     //CacheListIndex();    
     return nfiles;
@@ -430,33 +451,149 @@ unsigned int FileCache::GetNumLumps(int filenum)
 //==============
 
 
+/// Makes the index key from a lump name: first 8 chars in uppercase, NUL-padded.
+static inline void MakeLumpKey(const char *name, Uint32 *key)
+{
+  union
+  {
+    char s[8];
+    Uint32 x[2];
+  };
+
+  x[0] = x[1] = 0;
+  for (int i = 0; i < 8 && name[i]; i++)
+    s[i] = toupper(name[i]);
+
+  key[0] = x[0];
+  key[1] = x[1];
+}
+
+
+static inline unsigned HashLumpKey(const Uint32 *key)
+{
+  Uint32 h = key[0] * 0x9e3779b1u;
+  h ^= (h >> 15) ^ key[1] * 0x85ebca77u;
+  return h ^ (h >> 13);
+}
+
+
+/// Returns the slot for the key, or the empty slot where it should go.
+FileCache::lumpslot_t *FileCache::FindSlot(const Uint32 *key)
+{
+  unsigned mask = lumphash.size() - 1;
+  for (unsigned i = HashLumpKey(key); ; i++)
+    {
+      n_probes++;
+      lumpslot_t *s = &lumphash[i & mask];
+      if (s->first < 0 || (s->key[0] == key[0] && s->key[1] == key[1]))
+	return s;
+    }
+}
+
+
+/// Rebuilds the lump name index from scratch after the set of VFiles has changed.
+void FileCache::BuildIndex()
+{
+  unsigned start = I_GetTime();
+  unsigned probes = n_probes; // only the lookups count
+
+  int total = 0;
+  int n = vfiles.size();
+  for (int i = 0; i < n; i++)
+    total += vfiles[i]->numitems;
+
+  // load factor at most 1/2
+  unsigned size = 64;
+  while (size < 2*unsigned(total))
+    size <<= 1;
+
+  lumpslot_t empty = {{0, 0}, -1, -1};
+  lumphash.assign(size, empty);
+  lumpnums.resize(total);
+  lumpnext.resize(total);
+  lumpprev.resize(total);
+
+  // entries are added in lump number order, so the chains stay sorted
+  int e = 0;
+  for (int i = 0; i < n; i++)
+    {
+      VFile *vf = vfiles[i];
+      for (int j = 0; j < vf->numitems; j++, e++)
+	{
+	  Uint32 key[2];
+	  MakeLumpKey(vf->GetItemName(j), key);
+	  lumpslot_t *s = FindSlot(key);
+
+	  lumpnums[e] = (i << 16) + j;
+	  lumpnext[e] = -1;
+	  if (s->first < 0)
+	    {
+	      s->key[0] = key[0];
+	      s->key[1] = key[1];
+	      s->first = e;
+	      lumpprev[e] = -1;
+	    }
+	  else
+	    {
+	      lumpnext[s->last] = e;
+	      lumpprev[e] = s->last;
+	    }
+	  s->last = e;
+	}
+    }
+
+  index_valid = true;
+  n_probes = probes;
+  n_rebuilds++;
+  build_ms += I_GetTime() - start;
+}
+
+
 // Returns -1 if name not found.
 // scanforward: this is normally always false, so external pwads take precedence.
 int FileCache::FindNumForName(const char* name, bool scanforward)
 {
-  int i, n = vfiles.size();
-  int res;
+  if (!index_valid)
+    BuildIndex();
+
+  n_lookups++;
+  Uint32 key[2];
+  MakeLumpKey(name, key);
+  lumpslot_t *s = FindSlot(key);
 
   if (!scanforward)
     {
-      // scan wad files backwards so patch lump files take precedence
-      for (i = n-1; i >= 0; i--)
+      // The last wad file takes precedence, but within a wad file the first lump does,
+      // so walk the chain backwards until we leave the file of the latest match.
+      int res = -1;
+      for (int e = s->last; e >= 0; e = lumpprev[e])
 	{
-	  res = vfiles[i]->FindNumForName(name);
-	  // high word is the wad file number, low word the lump number
-	  if (res != -1)
-	    return ((i<<16) + res);
+	  n_chainsteps++;
+	  int lump = lumpnums[e];
+	  if (res != -1 && (lump >> 16) != (res >> 16))
+	    break;
+
+	  if (vfiles[lump >> 16]->MatchItem(lump & 0xffff, name, key))
+	    res = lump;
 	}
+
+      if (res != -1)
+	n_found++;
+      return res;
     }
   else
-    {  
+    {
       // scan wad files forward, when original wad resources
       //  must take precedence
-      for (i = 0; i<n; i++)
+      for (int e = s->first; e >= 0; e = lumpnext[e])
 	{
-	  res = vfiles[i]->FindNumForName(name);
-	  if (res != -1)
-	    return ((i<<16) + res);
+	  n_chainsteps++;
+	  int lump = lumpnums[e];
+	  if (vfiles[lump >> 16]->MatchItem(lump & 0xffff, name, key))
+	    {
+	      n_found++;
+	      return lump;
+	    }
 	}
     }
   // not found.
@@ -485,11 +622,32 @@ int FileCache::FindNumForNameFile(const char* name, unsigned filenum, int startl
 
   if (filenum >= vfiles.size())
     I_Error("FileCache::FindNumForNamePwad: %i >= numvfiles(%i)\n", filenum, vfiles.size());
- 
-  int res = vfiles[filenum]->FindNumForName(name, startlump);
 
-  if (res != -1) return ((filenum<<16) + res);
-  
+  if (!index_valid)
+    BuildIndex();
+
+  n_lookups++;
+  Uint32 key[2];
+  MakeLumpKey(name, key);
+  lumpslot_t *s = FindSlot(key);
+
+  int start = (filenum << 16) + startlump;
+  for (int e = s->first; e >= 0; e = lumpnext[e])
+    {
+      n_chainsteps++;
+      int lump = lumpnums[e];
+      if (lump < start)
+	continue;
+      if (unsigned(lump >> 16) > filenum)
+	break;
+
+      if (vfiles[filenum]->MatchItem(lump & 0xffff, name, key))
+	{
+	  n_found++;
+	  return lump;
+	}
+    }
+
   // not found.
   return -1;
 }
@@ -585,9 +743,50 @@ void *FileCache::CacheLumpNum(int lump, int tag, bool add_NUL)
 }
 
 
+const void *FileCache::AcquireLump(int lump)
+{
+  int item = lump & 0xffff;
+  unsigned int file = lump >> 16;
+
+  if (file >= vfiles.size())
+    I_Error("FileCache::AcquireLump: %i >= numvfiles(%i)\n", file, vfiles.size());
+  if (item >= vfiles[file]->numitems)
+    I_Error("FileCache::AcquireLump: %i >= numitems", item);
+
+  VFile *vf = vfiles[file];
+  const byte *p = vf->MapItem(item);
+  if (p)
+    {
+      n_mapped++;
+      mapped_bytes += vf->GetItemSize(item);
+      return p;
+    }
+
+  // A private copy, since the shared CacheItem buffer may be in use (and converted in place) elsewhere.
+  int size = vf->GetItemSize(item);
+  n_copied++;
+  copied_bytes += size;
+  void *copy = Z_Malloc(size, PU_STATIC, NULL);
+  vf->ReadItem(item, copy, size);
+  return copy;
+}
+
+
+void FileCache::ReleaseLump(int lump, const void *data)
+{
+  if (!data)
+    return;
+
+  // only the private copies are freed
+  if (data != vfiles[lump >> 16]->MapItem(lump & 0xffff))
+    Z_Free(const_cast<void*>(data));
+}
+
+
 void FileCache::CacheArchiveFile(VFile* vf)
 {
   vfiles.push_back(vf);
+  index_valid = false;
 }
 
 Uint16 FileCache::CacheArchiveFile_Remove()
@@ -602,6 +801,7 @@ Uint16 FileCache::CacheArchiveFile_Remove()
                 CONS_Printf("*ZIP/PK3 Entferne: %s aus der internen VfileList\n", vfiles[k]->filename.c_str());
                 delete vfiles[k];  // Füge das hinzu, falls nicht schon in ~FileCache!
                 vfiles.erase(vfiles.begin() + k);
+                index_valid = false;
                 // Kein k++, da nächstes jetzt an k ist
             }
             else
@@ -617,6 +817,212 @@ Uint16 FileCache::CacheArchiveFile_Remove()
     return vfiles.size();
 }
   
+void FileCache::PrintStats()
+{
+  if (!index_valid)
+    BuildIndex();
+
+  unsigned names = 0, longest = 0;
+  for (unsigned i = 0; i < lumphash.size(); i++)
+    if (lumphash[i].first >= 0)
+      {
+	names++;
+	unsigned len = 0;
+	for (int e = lumphash[i].first; e >= 0; e = lumpnext[e])
+	  len++;
+	if (len > longest)
+	  longest = len;
+      }
+
+  CONS_Printf("\2Lump index\n");
+  CONS_Printf("%d files, %d lumps, %d distinct names, longest chain %d\n", vfiles.size(), lumpnums.size(), names, longest);
+  CONS_Printf("hash table: %d slots, rebuilt %d times, %d ms total\n", lumphash.size(), n_rebuilds, build_ms);
+  CONS_Printf("%d lookups, %d found\n", n_lookups, n_found);
+  if (n_lookups)
+    CONS_Printf("%.2f probes and %.2f chain steps per lookup\n", float(n_probes) / n_lookups, float(n_chainsteps) / n_lookups);
+
+  CONS_Printf("\2Lump access\n");
+  CONS_Printf("zero-copy: %d lumps, %.0f kB\n", n_mapped, mapped_bytes / 1024);
+  CONS_Printf("copied:    %d lumps, %.0f kB\n", n_copied, copied_bytes / 1024);
+}
+
+
+void Command_LumpInfo_f()
+{
+  fc.PrintStats();
+}
+
+
+//======================
+//  digest cache
+//======================
+
+#define DIGESTCACHE_HEADER "# Doom Legacy digest cache"
+
+void FileCache::LoadDigests()
+{
+  digests_loaded = true;
+  digests.clear();
+
+  if (digestfile.empty())
+    return;
+
+  FILE *f = fopen(digestfile.c_str(), "rt");
+  if (!f)
+    return;
+
+  // each line: md5 size mtime inode filename
+  char line[1024];
+  while (fgets(line, sizeof(line), f))
+    {
+      if (line[0] == '#')
+	continue;
+
+      char hex[33];
+      long long size, mtime, inode;
+      int n = 0;
+      if (sscanf(line, "%32s %lld %lld %lld %n", hex, &size, &mtime, &inode, &n) < 4 || strlen(hex) != 32)
+	continue;
+
+      char *name = line + n;
+      name[strcspn(name, "\r\n")] = '\0';
+      if (!*name)
+	continue;
+
+      digest_t d;
+      d.size = size;
+      d.mtime = mtime;
+      d.inode = inode;
+      for (int i = 0; i < 16; i++)
+	{
+	  unsigned b;
+	  sscanf(hex + 2*i, "%2x", &b);
+	  d.md5[i] = b;
+	}
+
+      digests[name] = d;
+    }
+
+  fclose(f);
+}
+
+
+void FileCache::SaveDigests()
+{
+  digests_dirty = false;
+
+  if (digestfile.empty())
+    return;
+
+  FILE *f = fopen(digestfile.c_str(), "wt");
+  if (!f)
+    {
+      CONS_Printf("Could not write the digest cache '%s'.\n", digestfile.c_str());
+      return;
+    }
+
+  fprintf(f, DIGESTCACHE_HEADER "\n");
+  for (map<string, digest_t>::iterator i = digests.begin(); i != digests.end(); i++)
+    {
+      digest_t &d = i->second;
+      for (int k = 0; k < 16; k++)
+	fprintf(f, "%02x", d.md5[k]);
+      fprintf(f, " %lld %lld %lld %s\n", (long long)d.size, (long long)d.mtime, (long long)d.inode, i->first.c_str());
+    }
+
+  fclose(f);
+}
+
+
+void FileCache::UpdateDigests()
+{
+  if (!digests_loaded)
+    LoadDigests();
+
+  // Only VDataFiles ever have invalid digests.
+  // Files without a stream live in memory, so they are cheap to hash and are not cached.
+  vector<VDataFile *> misses;
+  int hits = 0;
+  for (unsigned i = 0; i < vfiles.size(); i++)
+    {
+      if (vfiles[i]->DigestValid())
+	continue;
+
+      VDataFile *vf = static_cast<VDataFile *>(vfiles[i]);
+      if (vf->stream)
+	{
+	  map<string, digest_t>::iterator j = digests.find(vf->filename);
+	  if (j != digests.end() &&
+	      j->second.size == vf->size && j->second.mtime == vf->mtime && j->second.inode == vf->inode)
+	    {
+	      memcpy(vf->md5sum, j->second.md5, 16);
+	      vf->md5valid = true;
+	      hits++;
+	      continue;
+	    }
+	}
+
+      misses.push_back(vf);
+    }
+
+  if (misses.empty())
+    return;
+
+  unsigned start = I_GetTime();
+  workers.ParallelFor(misses.size(), [&misses](int i) { misses[i]->ComputeDigest(); });
+
+  double bytes = 0;
+  for (unsigned i = 0; i < misses.size(); i++)
+    {
+      VDataFile *vf = misses[i];
+      vf->md5valid = true;
+      if (!vf->stream)
+	continue;
+
+      bytes += vf->size;
+      digest_t &d = digests[vf->filename];
+      d.size = vf->size;
+      d.mtime = vf->mtime;
+      d.inode = vf->inode;
+      memcpy(d.md5, vf->md5sum, 16);
+      digests_dirty = true;
+    }
+
+  CONS_Printf("Digests: %d cached, %d hashed (%.1f MB) in %d ms\n", hits, misses.size(), bytes / (1024*1024), I_GetTime() - start);
+
+  if (digests_dirty)
+    SaveDigests();
+}
+
+
+bool FileCache::GetIdentityKey(byte *md5)
+{
+  md5_ctx ctx;
+  md5_init_ctx(&ctx);
+  for (unsigned i = 0; i < vfiles.size(); i++)
+    {
+      VFile *vf = vfiles[i];
+      Sint64 id[3];
+      if (vf->GetIdentity(&id[0], &id[1], &id[2]))
+	{
+	  md5_process_bytes(vf->filename.c_str(), vf->filename.size() + 1, &ctx);
+	  md5_process_bytes(id, sizeof(id), &ctx);
+	  continue;
+	}
+
+      int  size;
+      byte digest[16];
+      if (!vf->GetNetworkInfo(&size, digest))
+	return false;
+
+      md5_process_bytes(&size, sizeof(size), &ctx);
+      md5_process_bytes(digest, 16, &ctx);
+    }
+  md5_finish_ctx(&ctx, md5);
+  return true;
+}
+
+
 Uint8 FileCache::CacheListIndex(void)
 {  
     
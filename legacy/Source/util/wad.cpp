@@ -20,8 +20,10 @@
 /// \brief Wad, Wad3, Pak and ZipFile classes: datafile I/O
 
 #include <stdio.h>
+#include <ctype.h>
 #include <sys/stat.h>
 #include <zlib.h>
+#include <chrono>
 
 #include <unistd.h>
 #include <sys/stat.h>   // mkdir (Linux/MSYS) oder _mkdir (Windows)
@@ -35,6 +37,8 @@
 
 #include "m_swap.h"
 #include "m_misc.h"
+#include "m_threads.h"
+#include "md5.h"
 #include "parser.h"
 #include "dehacked.h"
 
@@ -200,6 +204,9 @@ bool Wad::Open(const char *fname)
 
   Z_Free(temp);
 
+  // lumps are stored uncompressed, so they can be used directly from a mapping
+  MapFile();
+
   h.numentries = 0; // what a great hack!
   CONS_Printf(" Added %s file %s (%i lumps)\n", h.magic, filename.c_str(), numitems);
   LoadDehackedLumps();
@@ -221,11 +228,29 @@ const char *Wad::GetItemName(int i)
 int Wad::Internal_ReadItem(int lump, void *dest, unsigned size, unsigned offset)
 {
   waddir_t *l = directory + lump;
+
+  const byte *m = MapItem(lump);
+  if (m)
+    {
+      memcpy(dest, m + offset, size); // VFile::ReadItem has already clamped size
+      return size;
+    }
+
   fseek(stream, l->offset + offset, SEEK_SET);
   return fread(dest, 1, size, stream); 
 }
 
 
+const byte *Wad::MapItem(int lump)
+{
+  waddir_t *l = directory + lump;
+  if (!mapping || l->size == 0 || l->offset > unsigned(size) || l->size > unsigned(size) - l->offset)
+    return NULL; // truncated wads must go through fread
+
+  return mapping + l->offset;
+}
+
+
 void Wad::ListItems()
 {
   waddir_t *p = directory;
@@ -272,6 +297,13 @@ int Wad::FindNumForName(const char *name, int startlump)
 }
 
 
+// The key is exactly what FindNumForName compares against.
+bool Wad::MatchItem(int i, const char *name, const Uint32 *key)
+{
+  return directory[i].iname[0] == key[0] && directory[i].iname[1] == key[1];
+}
+
+
 int Wad::FindPartialName(Uint32 iname, int startlump, const char **fullname)
 {
   // checks only first 4 characters, returns full name
@@ -645,6 +677,12 @@ int WadFromMemory::FindNumForName(const char *name, int startlump)
 }
 
 
+bool WadFromMemory::MatchItem(int i, const char *name, const Uint32 *key)
+{
+  return directory[i].iname[0] == key[0] && directory[i].iname[1] == key[1];
+}
+
+
 int WadFromMemory::FindPartialName(Uint32 iname, int startlump, const char **fullname)
 {
   // checks only first 4 characters, returns full name
@@ -690,6 +728,24 @@ int WadFromMemory::Internal_ReadItem(int item, void *dest, unsigned size, unsign
   return read_size;
 }
 
+
+const byte *WadFromMemory::MapItem(int item)
+{
+  waddir_t *l = &directory[item];
+  if (!memory_data || l->size == 0 || l->offset > memory_size || l->size > memory_size - l->offset)
+    return NULL;
+
+  return memory_data + l->offset;
+}
+
+void WadFromMemory::ComputeDigest()
+{
+  if (memory_data)
+    md5_buffer(reinterpret_cast<const char*>(memory_data), memory_size, md5sum);
+  else
+    memset(md5sum, 0, sizeof(md5sum));
+}
+
 void WadFromMemory::ListItems()
 {
   waddir_t *p = directory;
@@ -853,6 +909,14 @@ int Wad3::FindNumForName(const char *name, int startlump)
 }
 
 
+bool Wad3::MatchItem(int i, const char *name, const Uint32 *key)
+{
+  char s[16];
+  strncpy(s, name, 16);
+  return !memcmp(directory[i].name, s, 16);
+}
+
+
 
 //=============================
 //  Pak class implementation
@@ -1035,12 +1099,78 @@ struct zipdir_t
 #pragma pack(pop)
 static_assert(sizeof(zipdir_t) == 4+4+4+65+1, "zipdir_t muss 78 Bytes sein!");
 
+
+/// Decompression statistics for all ZipFiles.
+static struct
+{
+  unsigned inflated;       ///< lumps inflated, including prefetched ones
+  unsigned prefetched;     ///< lumps inflated by Prefetch
+  unsigned prefetch_calls;
+  unsigned stored;         ///< reads of uncompressed lumps
+  double   in_bytes, out_bytes;
+  double   inflate_ms;     ///< summed over all threads
+  double   prefetch_ms;    ///< wall time spent in Prefetch
+} zipstats;
+
+
 ZipFile::ZipFile()
 {
   directory = NULL;
 }
 
 
+/// FNV-1a hash of the item name. Case sensitive, like the other VFile name lookups.
+static Uint32 ZIP_HashName(const char *name)
+{
+  Uint32 h = 2166136261u;
+  for ( ; *name; name++)
+    h = (h ^ byte(*name)) * 16777619u;
+
+  return h;
+}
+
+
+void ZipFile::BuildIndex()
+{
+  unsigned hsize = 16;
+  while (hsize < 2 * unsigned(numitems))
+    hsize <<= 1;
+
+  namehash.assign(hsize, -1);
+  namenext.assign(numitems, -1);
+
+  // insert backwards so that each chain ends up in increasing item order
+  for (int i = numitems - 1; i >= 0; i--)
+    {
+      unsigned k = ZIP_HashName(directory[i].name) & (hsize - 1);
+      while (namehash[k] >= 0 && strcmp(directory[namehash[k]].name, directory[i].name))
+	k = (k + 1) & (hsize - 1);
+
+      namenext[i] = namehash[k];
+      namehash[k] = i;
+    }
+}
+
+
+int ZipFile::FindNumForName(const char *name, int startitem)
+{
+  if (namehash.empty())
+    return -1;
+
+  unsigned mask = namehash.size() - 1;
+  for (unsigned k = ZIP_HashName(name) & mask; namehash[k] >= 0; k = (k + 1) & mask)
+    if (!strcmp(directory[namehash[k]].name, name))
+      {
+	for (int i = namehash[k]; i >= 0; i = namenext[i])
+	  if (i >= startitem)
+	    return i;
+	break;
+      }
+
+  return -1;
+}
+
+
 ZipFile::~ZipFile()
 {
   
@@ -1204,8 +1334,14 @@ bool ZipFile::Open(const char *fname)
   if (!VDataFile::Open(fname))
     return false;
 
-  CONS_Printf(" ZipFile -> Open: \"%s\"\n",fname);
-  CONS_Printf("------------------------------------------------------------\n"); 
+  // the local headers and stored lumps are read straight from the mapping, if possible
+  MapFile();
+
+  if (devparm)
+    {
+      CONS_Printf(" ZipFile -> Open: \"%s\"\n",fname);
+      CONS_Printf("------------------------------------------------------------\n");
+    }
   // Find and read the central directory end.
   // We have to go through this because of the stupidly-placed ZIP comment field...
   
@@ -1300,8 +1436,13 @@ bool ZipFile::Open(const char *fname)
     
     // check if the local file header matches the central directory entry
     zip_local_header_t lh;
-    fseek(stream, directory[item].offset, SEEK_SET);
-    fread(&lh, sizeof(zip_local_header_t), 1, stream);
+    if (mapping && directory[item].offset + sizeof(zip_local_header_t) <= unsigned(size))
+      memcpy(&lh, mapping + directory[item].offset, sizeof(zip_local_header_t));
+    else
+    {
+      fseek(stream, directory[item].offset, SEEK_SET);
+      fread(&lh, sizeof(zip_local_header_t), 1, stream);
+    }
 
     /* Get Singnature PK \3 \4 */
     if (ZIP_Get_Signature_PK34(lh, fname, directory[item].name ) != 0)
@@ -1314,7 +1455,7 @@ bool ZipFile::Open(const char *fname)
     // make offset point directly to the data
     directory[item].offset += sizeof(zip_local_header_t) + SHORT(lh.filename_size) + SHORT(lh.extrafield_size);
          
-    if (item < 10)
+    if (devparm && item < 10)
     {
       CONS_Printf(" [%s][%d] Contains\n",__FILE__,__LINE__);
       CONS_Printf("   Filename             :\"%s\"\n",               directory[item].name);
@@ -1327,16 +1468,14 @@ bool ZipFile::Open(const char *fname)
     
     const char *ext = strrchr(directory[item].name, '.');
     
-    ext++; // Nach dem Punkt
-    if (strcasecmp(ext, "wad") == 0)
+    if (ext && strcasecmp(ext + 1, "wad") == 0)
     {
       WadFile = true;
     }
     
-    imap.insert(pair<const char *, int>(directory[item].name, item)); // fill the name map
-    
     item++;
-    CONS_Printf("------------------------------------------------------------\n");      
+    if (devparm)
+      CONS_Printf("------------------------------------------------------------\n");
   }   
 
   // NOTE: If lumps are ignored, there will be a few empty records at the end of directory. Let them be.
@@ -1344,6 +1483,8 @@ bool ZipFile::Open(const char *fname)
   
   Z_Free(tempdir);
 
+  BuildIndex(); // name lookups
+
   // set up caching (Cache allokieren (nur für akzeptierte Items) )
   cache = (lumpcache_t *)Z_Malloc(numitems * sizeof(lumpcache_t), PU_STATIC, NULL);
   memset(cache, 0, numitems * sizeof(lumpcache_t));
@@ -1388,25 +1529,53 @@ bool ZipFile::Open(const char *fname)
  * file (e.g., only the .wad,.gwa,.deh,.lmp files) – without having to rescan
  * the entire ZIP file.
  */
+/// Returns true if the ZIP item is something GetItemListFromMemory extracts.
+static bool ZIP_IsContentFile(const char *name)
+{
+  static const char *exts[] = {"ACS", "DEH", "GWA", "HHE", "LMP", "RAW", "WAD", NULL};
+
+  const char *ext = strrchr(name, '.');
+  if (!ext)
+    return false;
+
+  for (int i = 0; exts[i]; i++)
+    if (!strcasecmp(ext + 1, exts[i]))
+      return true;
+
+  return false;
+}
+
+
 int ZipFile::GetItemListFromMemory()
 {
   //CONS_Printf(" ZIP/PK3 Get Item List From Memory\n");
   
-  ListItems();
+  if (devparm)
+    ListItems();
   
   Uint16 Added    = -1;
-  Uint8  isFormat = -1; 
+  int    isFormat = -1; 
   
   if (directory == NULL || numitems <= 0)
   {
     CONS_Printf("  [%s][%d]Error::GetItemListFromMemory:\n  -> Kein Verzeichnis oder keine Items (numitems = %d)\n", numitems);
     return Added;
   }
+
+    // inflate everything we are going to extract in parallel
+    vector<int> wanted;
+    for (int i = 0; i < numitems; i++)
+      if (directory[i].size >= 12 && ZIP_IsContentFile(directory[i].name))
+        wanted.push_back(i);
+
+    if (!wanted.empty())
+      Prefetch(&wanted[0], wanted.size());
  
     for (int i = 0; i < numitems; i++)
     {
       char InternalLumpName[9]; // For *.LMP or Dehacked
       zipdir_t *l = &directory[i];
+      isFormat = -1;
       
       if (l->size < 12) continue; // zu klein für WAD-Header
 
@@ -1430,7 +1599,7 @@ int ZipFile::GetItemListFromMemory()
         byte* wad_data = (byte*)Z_Malloc(l->size, PU_STATIC, NULL);
         if (!wad_data) continue;
 
-        uint32_t read = Internal_ReadItem(i, wad_data, l->size, 0);
+        uint32_t read = ReadItem(i, wad_data, l->size, 0); // prefetched lumps are already in the cache
         if (read != l->size)
         {
           Z_Free(wad_data); continue;
@@ -1551,152 +1720,277 @@ void ZipFile::ListItems()
   //memset(cache, 0, numitems * sizeof(lumpcache_t));  
 }
 
-int ZipFile::Internal_ReadItem(int item, void *dest, uint32_t size, uint32_t offset)
+/// Inflates a raw DEFLATE stream of csize bytes into exactly usize bytes.
+/// Touches no global state, so it is safe to call from worker threads.
+static bool ZIP_Inflate(const byte *src, unsigned csize, byte *dest, unsigned usize)
+{
+  z_stream zs; // stores the decompressor state
+  zs.zalloc   = Z_NULL;
+  zs.zfree    = Z_NULL;
+  zs.opaque   = Z_NULL;
+  zs.avail_in = 0;
+  zs.next_in  = Z_NULL;
+
+  if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) // tell zlib not to expect any headers
+    return false;
+
+  zs.next_in   = const_cast<byte*>(src);
+  zs.avail_in  = csize;
+  zs.next_out  = dest;
+  zs.avail_out = usize;
+
+  int ret = inflate(&zs, Z_FINISH);
+  inflateEnd(&zs);
+
+  // the stream may legally continue past the declared size, we only need that much
+  return zs.avail_out == 0 && (ret == Z_STREAM_END || ret == Z_OK || ret == Z_BUF_ERROR);
+}
+
+
+static double ZIP_Ms(chrono::steady_clock::time_point start)
+{
+  return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+
+const byte *ZipFile::MapCompressed(int item)
 {
   zipdir_t *l = directory + item;
-  
-  const char *ext = strrchr(l->name, '.');
-  if (ext)    
+  if (!mapping || l->offset > unsigned(size) || l->compressed_size > unsigned(size) - l->offset)
+    return NULL;
+
+  return mapping + l->offset;
+}
+
+
+const byte *ZipFile::MapItem(int item)
+{
+  if (directory[item].deflated)
+    return NULL;
+
+  return MapCompressed(item);
+}
+
+
+bool ZipFile::InflateItem(int item, byte *dest)
+{
+  zipdir_t *l = directory + item;
+
+  const byte *src = MapCompressed(item);
+  byte *temp = NULL;
+  if (!src)
+    {
+      temp = static_cast<byte*>(Z_Malloc(l->compressed_size, PU_STATIC, NULL));
+      fseek(stream, l->offset, SEEK_SET); // seek to lump start within the file
+      if (fread(temp, 1, l->compressed_size, stream) != l->compressed_size)
+	{
+	  Z_Free(temp);
+	  return false;
+	}
+      src = temp;
+    }
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  bool ok = ZIP_Inflate(src, l->compressed_size, dest, l->size);
+  zipstats.inflate_ms += ZIP_Ms(start);
+
+  if (temp)
+    Z_Free(temp);
+
+  if (ok)
+    {
+      zipstats.inflated++;
+      zipstats.in_bytes  += l->compressed_size;
+      zipstats.out_bytes += l->size;
+    }
+
+  return ok;
+}
+
+
+int ZipFile::Prefetch(const int *items, int n)
+{
+  // Everything touching the zone or the stream is done here in the main thread,
+  // the workers only inflate from one buffer to another.
+  struct zipjob_t
   {
-    ext++; // nach dem Punkt
-    string_to_upper(ext);
-  }
-  
-  CONS_Printf("\n-------------------------------------------------ZIP EXTRACT\n"); 
+    zipdir_t   *l;
+    const byte *src;
+    byte       *temp; ///< compressed data if the file is not mapped
+    byte       *dest;
+    bool        ok;
+    double      ms;
+  };
+
+  vector<zipjob_t> jobs;
+  for (int i = 0; i < n; i++)
+    {
+      int item = items[i];
+      if (item < 0 || item >= numitems || cache[item])
+	continue; // already cached (or requested twice)
+
+      zipdir_t *l = directory + item;
+      if (!l->deflated || l->size == 0)
+	continue; // reading these is cheap anyway
+
+      zipjob_t j;
+      j.l = l;
+      j.temp = NULL;
+      j.src = MapCompressed(item);
+      if (!j.src)
+	{
+	  j.temp = static_cast<byte*>(Z_Malloc(l->compressed_size, PU_STATIC, NULL));
+	  fseek(stream, l->offset, SEEK_SET);
+	  if (fread(j.temp, 1, l->compressed_size, stream) != l->compressed_size)
+	    {
+	      Z_Free(j.temp);
+	      continue;
+	    }
+	  j.src = j.temp;
+	}
+
+      j.dest = static_cast<byte*>(Z_Malloc(l->size, PU_STATIC, &cache[item]));
+      j.ok = false;
+      j.ms = 0;
+      jobs.push_back(j);
+    }
+
+  if (jobs.empty())
+    return 0;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  jobgroup_t g;
+  for (unsigned i = 0; i < jobs.size(); i++)
+    {
+      zipjob_t *j = &jobs[i];
+      workers.Submit(g, [j]() {
+	  chrono::steady_clock::time_point t = chrono::steady_clock::now();
+	  j->ok = ZIP_Inflate(j->src, j->l->compressed_size, j->dest, j->l->size);
+	  j->ms = ZIP_Ms(t);
+	});
+    }
+  workers.Wait(g);
+
+  zipstats.prefetch_calls++;
+  zipstats.prefetch_ms += ZIP_Ms(start);
+
+  int done = 0;
+  for (unsigned i = 0; i < jobs.size(); i++)
+    {
+      zipjob_t &j = jobs[i];
+      if (j.temp)
+	Z_Free(j.temp);
+
+      if (!j.ok)
+	{
+	  // leave it to Internal_ReadItem to complain if someone actually needs it
+	  Z_Free(j.dest);
+	  continue;
+	}
+
+      done++;
+      zipstats.inflated++;
+      zipstats.prefetched++;
+      zipstats.in_bytes   += j.l->compressed_size;
+      zipstats.out_bytes  += j.l->size;
+      zipstats.inflate_ms += j.ms;
+    }
+
+  return done;
+}
+
+
+int ZipFile::Internal_ReadItem(int item, void *dest, uint32_t size, uint32_t offset)
+{
   if (item >= numitems || item < 0)
-  {
-      CONS_Printf("ERROR: Ungültiger ZIP-Item %d\n", item);
+    {
+      CONS_Printf("ZipFile: Invalid item %d in '%s'.\n", item, filename.c_str());
       return 0;
-  }
+    }
 
+  zipdir_t *l = directory + item;
   if (l->size == 0)
-  {
-      CONS_Printf("WARN: ZIP-Item %d hat Größe 0\n", item);
-      return 0;
-  }
-    
+    return 0;
+
   if (!l->deflated)
-  {
+    {
+      zipstats.stored++;
+      const byte *p = MapItem(item);
+      if (p)
+	{
+	  memcpy(dest, p + offset, size);
+	  return size;
+	}
+
       fseek(stream, l->offset + offset, SEEK_SET); // skip to correct offset within the uncompressed lump
       return fread(dest, 1, size, stream); // uncompressed lump
-  }
+    }
 
-  //CONS_Printf(" Debug - [%s][%d]::Internal_ReadItem %s\n",__FILE__,__LINE__,l->name);
-    
   // DEFLATEd lump, uncompress it
 
   // NOTE: inflating compressed lumps can be expensive, so we transparently cache them at first use.
   // This way we only have to inflate the lump once. Uncompressed lumps are treated as usual.
-  // NOTE: this function is only called when an item has not been found in the lumpcache.
+  // NOTE: this function is only called when an item has not been found in the lumpcache,
+  // use Prefetch to inflate several lumps at once in parallel.
 
-  fseek(stream, l->offset, SEEK_SET); // seek to lump start within the file
-
-  unsigned unpack_size = l->size;
   if (!cache[item])
-    Z_Malloc(unpack_size, PU_STATIC, &cache[item]); // even if cache[item] is allocated, it is not yet filled with data
-
-  z_stream zs; // stores the decompressor state
-
-  // output buffer
-  zs.avail_out = unpack_size;
-  zs.next_out  = static_cast<byte*>(cache[item]);
+    Z_Malloc(l->size, PU_STATIC, &cache[item]); // even if cache[item] is allocated, it is not yet filled with data
 
-  int chunksize = min(max(unpack_size, 256u), 8192u); // guesstimate
-  byte in[chunksize];
-
-  zs.zalloc   = Z_NULL;
-  zs.zfree    = Z_NULL;
-  zs.opaque   = Z_NULL;
-  zs.avail_in = 0;
-  zs.next_in  = Z_NULL;
+  if (!InflateItem(item, static_cast<byte*>(cache[item])))
+    I_Error("ZipFile: Error decompressing '%s' in '%s'.\n", l->name, filename.c_str());
 
-  // TODO more informative error messages
-  int ret = inflateInit2(&zs, -MAX_WBITS); // tell zlib not to expect any headers
-  if (ret != Z_OK)
-    I_Error(" [%s][%d]::Internal_ReadItem: Fatal zlib error.\n",__FILE__,__LINE__);
+  // now the lump is uncompressed and cached, see if it is something we can use
+  const char *ext = strrchr(l->name, '.');
+  const char *what = NULL;
+
+  if (memcmp(cache[item], "IWAD", 4) == 0 ||
+      memcmp(cache[item], "PWAD", 4) == 0)
+    what = "WAD";
+  else if (memcmp(cache[item], "FORM", 4) == 0) // Optional: MIDI oder andere RIFF-Formate
+    what = "FORM";
+  else if (ext && strcasecmp(ext + 1, "LMP") == 0)
+    what = "Demo (.lmp)"; // Single  Lump File
+  else if (memcmp(cache[item], "Patch File for DeHackEd", 23) == 0)
+    what = "DeHackEd-Patch";
+  else if (memcmp(cache[item], "Patch File for HHE", 18) == 0) // DEHACKED Heretic
+    what = "Heritage DeHackEd-Patch";
+  else if (memcmp(cache[item], "BEHAVIOR", 8) == 0)
+    what = "ACS BEHAVIOR";
 
-  // decompress until deflate stream ends or we have enough data
-  do
+  if (!what)
     {
-      // get some input
-      // NOTE: we may fread past the end of the lump, but that should not be harmful.
-      zs.avail_in = fread(in, 1, chunksize, stream);
-      if (ferror(stream) || zs.avail_in == 0)
-      {
-        inflateEnd(&zs);
-          I_Error(" [%s][%d]::Internal_ReadItem: Error decompressing a ZIP lump!\n",__FILE__,__LINE__);
-      }
+      if (devparm)
+	CONS_Printf(" ?ZIP/PK3 Successful Extracted \"%s\" %u Bytes but not relevant game content...\n", l->name, l->size);
+      return 0;
+    }
 
-      zs.next_in = in;
+  if (devparm)
+    CONS_Printf(" ZIP/PK3 %s: %s (%u Bytes)\n", what, l->name, l->size);
 
-      // decompress as much as possible
-      ret = inflate(&zs, Z_SYNC_FLUSH);
-    } while (ret == Z_OK && zs.avail_out != 0); // decompression can continue && not done yet
+  memcpy(dest, static_cast<byte*>(cache[item]) + offset, size);
+  return size;
+}
 
-  inflateEnd(&zs);
 
-  switch (ret)
-  {
-    case Z_STREAM_END:
-    {
-      // ran out of input
-      if (zs.avail_out != 0)
-        I_Error(" [%s][%d]::Internal_ReadItem: DEFLATE stream ended prematurely.\n",__FILE__,__LINE__);
-    }
-    // fallthru
-    case Z_OK:
-      break;
+void ZipFile::PrintStats()
+{
+  CONS_Printf("\2ZIP/PK3 decompression\n");
+  CONS_Printf("%d worker threads\n", workers.NumThreads());
+  CONS_Printf("inflated %d lumps, %.0f kB -> %.0f kB", zipstats.inflated, zipstats.in_bytes / 1024, zipstats.out_bytes / 1024);
+  if (zipstats.in_bytes > 0)
+    CONS_Printf(" (ratio %.2f)", zipstats.out_bytes / zipstats.in_bytes);
+  CONS_Printf("\n");
+  CONS_Printf("inflate time %.1f ms", zipstats.inflate_ms);
+  if (zipstats.inflate_ms > 0)
+    CONS_Printf(", %.1f MB/s", zipstats.out_bytes / 1048.576 / zipstats.inflate_ms);
+  CONS_Printf("\n");
+  CONS_Printf("prefetched %d lumps in %d calls, %.1f ms wall time\n", zipstats.prefetched, zipstats.prefetch_calls, zipstats.prefetch_ms);
+  CONS_Printf("%d reads of stored lumps\n", zipstats.stored);
+}
 
-    case Z_NEED_DICT:
-    case Z_DATA_ERROR:
-    case Z_STREAM_ERROR:
-    case Z_MEM_ERROR:
-    case Z_BUF_ERROR:
-    default:
-      I_Error("Error while decompressing a ZIP lump!\n",__FILE__,__LINE__);
-      break;
-    }
-  // successful
-  // Magic prüfen
-  Uint8 isFormat = -1;
-  
-  if (      memcmp(cache[item], "IWAD", 4) == 0) isFormat = 0; // IWAD
-  else if  (memcmp(cache[item], "PWAD", 4) == 0) isFormat = 1; // PWAD
-  else if  (memcmp(cache[item], "FORM", 4) == 0) isFormat = 4; // Optional: MIDI oder andere RIFF-Formate
-  else if  (strcasecmp(ext, "LMP")         == 0)
-  {
-    isFormat = 3; // Single  Lump File
-    CONS_Printf(" ZIP/PK3 Demo (.lmp) als Single-Lump geladen: %s (%zu Bytes)\n", l->name, size);
-  }
-  else if (memcmp(cache[item], "Patch File for DeHackEd", 23) == 0)
-  {
-    isFormat = 3; // Dehacked Doom or Heretic (Heritage DeHackEd HHE))
-    CONS_Printf(" ZIP/PK3 DeHackEd-Patch als Single-Lump geladen: %s (%zu Bytes)\n", l->name, size);    
-     
-  }
-  else if (memcmp(cache[item], "Patch File for HHE",18) == 0)// DEHACKED Heretic
-  {
-    isFormat = 3; // Dehacked Doom or Heretic (Heritage DeHackEd HHE))
-    CONS_Printf(" ZIP/PK3 Heritage DeHackEd-Patch als Single-Lump geladen: %s (%zu Bytes)\n", l->name, size);         
-  }              
-  else if (memcmp(cache[item],"BEHAVIOR",8)==0)
-  {
-     isFormat = 3;// ACS-Bytecode
-     CONS_Printf(" ZIP/PK3 ACS BEHAVIOR als Single-Lump geladen: %s (%zu Bytes)\n", l->name, size); 
-  }
-  else
-  {
-    CONS_Printf(" ?ZIP/PK3 Successful Extracted \"%s\" %zu Bytes but not relevant game content... \n",l->name,size/*cache[item]*/); 
-    return 0;
-  }
-  
-                 
-  //// now the lump is uncompressed and cached
-  if (isFormat >= 0)
-    
-    memcpy(dest, static_cast<byte*>(cache[item]) + offset, size);
-  else
-    return 0;
-  
-  return size;
+
+void Command_ZipInfo_f()
+{
+  ZipFile::PrintStats();
 }
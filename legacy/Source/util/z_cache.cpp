@@ -20,19 +20,25 @@
 /// \file
 /// \brief Abstract cache system with reference counting.
 
+#include <stdlib.h>
+
 #include "doomdef.h"
+#include "command.h"
 #include "z_cache.h"
 #include "z_zone.h"
 
 
 //=================================================================================
 
+unsigned cacheitem_t::clock = 0;
+
 cacheitem_t::cacheitem_t(const char *n)
 {
   strncpy(name, n, CACHE_NAME_LEN); // we make a copy so it stays intact as long as this cacheitem lives
   name[CACHE_NAME_LEN] = '\0';      // NUL-terminated to be safe
   refcount = 0;
   usefulness = 0;
+  lastuse = clock;
 }
 
 
@@ -69,6 +75,108 @@ bool cacheitem_t::FreeIfUnused()
 
 
 
+//=================================================================================
+
+cachebase_t *cachebase_t::caches = NULL;
+
+cachebase_t::cachebase_t(const char *n)
+{
+  cname = n;
+  budget = 0;
+  hits = misses = evictions = evicted_bytes = peak = 0;
+
+  // static instances, so the list is never modified afterwards
+  next = caches;
+  caches = this;
+}
+
+
+void cachebase_t::PrintStats()
+{
+  unsigned usage = Usage();
+  if (usage > peak)
+    peak = usage;
+
+  unsigned total = hits + misses;
+  CONS_Printf("%-10s %8d kB %8d kB %8d kB %5.1f%% %6d %8d kB\n", cname, usage >> 10, peak >> 10, budget >> 10,
+	      total ? 100.0 * hits / total : 0.0, evictions, evicted_bytes >> 10);
+}
+
+
+cachebase_t *cachebase_t::FindCache(const char *name)
+{
+  for (cachebase_t *c = caches; c; c = c->next)
+    if (!strcasecmp(c->cname, name))
+      return c;
+
+  return NULL;
+}
+
+
+void cachebase_t::Maintain()
+{
+  for (cachebase_t *c = caches; c; c = c->next)
+    if (c->budget)
+      c->Enforce();
+
+  cacheitem_t::clock++;
+}
+
+
+void cachebase_t::PrintAll()
+{
+  CONS_Printf("\2Cache Info\n");
+  CONS_Printf("cache          payload        peak      budget   hits  evict     evicted\n");
+  for (cachebase_t *c = caches; c; c = c->next)
+    c->PrintStats();
+}
+
+
+void Command_CacheInfo_f()
+{
+  cachebase_t::PrintAll();
+}
+
+
+void Command_CacheBudget_f()
+{
+  if (COM.Argc() != 3)
+    {
+      CONS_Printf("cache_budget <cache> <size[K|M]> : limit the payload of a cache, 0 means unlimited\n");
+      cachebase_t::PrintAll();
+      return;
+    }
+
+  const char *name = COM.Argv(1);
+  if (!strcasecmp(name, "materials"))
+    name = "textures"; // Materials are just wrappers for Textures
+
+  cachebase_t *c = cachebase_t::FindCache(name);
+  if (!c)
+    {
+      CONS_Printf("No cache named '%s'.\n", COM.Argv(1));
+      return;
+    }
+
+  char *end;
+  unsigned size = strtoul(COM.Argv(2), &end, 10);
+  switch (*end)
+    {
+    case 'k':
+    case 'K':
+      size <<= 10;
+      break;
+    case 'm':
+    case 'M':
+      size <<= 20;
+      break;
+    }
+
+  c->SetBudget(size);
+  CONS_Printf("%s: budget %d kB\n", c->GetName(), size >> 10);
+}
+
+
 //=================================================================================
 
 
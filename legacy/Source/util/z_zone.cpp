@@ -22,11 +22,15 @@
 /// \brief Zone Memory Allocation. Neat. Obsolete.
 
 #include <vector>
+#include <algorithm>
+#include <string.h>
 
 #include "doomdef.h"
+#include "command.h"
 #include "z_zone.h"
 #include "i_system.h"
 #include "i_video.h"
+#include "m_threads.h"
 
 
 using namespace std;
@@ -34,17 +38,24 @@ using namespace std;
 struct mem_extra_t
 {
   int    size;
-  int    tag;
+  Uint16 site;   ///< allocation profiler call site, zero if the block was not profiled
+  Uint8  tag;
+  Uint8  region; ///< index of the owning memregion_t plus one, or zero if the block was malloc'ed
   void **user;
 };
 
 static unsigned int mem_usage[PU_NUMTAGS];
+static unsigned int mem_peak[PU_NUMTAGS];
+
+#define MAX_REGIONS 64
+static memregion_t *regions[MAX_REGIONS]; ///< all existing memory regions
+static memregion_t *bound_region = NULL;  ///< the region currently serving PU_LEVEL and PU_LEVSPEC
 
 void Z_Init()
 {
   //CONS_Printf("Z_Init: Init zone memory allocation daemon.\n");
   for (int i=0; i<PU_NUMTAGS; i++)
-    mem_usage[i] = 0;
+    mem_usage[i] = mem_peak[i] = 0;
 }
 
 
@@ -57,6 +68,26 @@ unsigned Z_TagUsage(unsigned tagnum)
 }
 
 
+unsigned Z_TagPeak(unsigned tagnum)
+{
+  if (tagnum >= PU_NUMTAGS)
+    return 0;
+
+  return mem_peak[tagnum];
+}
+
+
+static inline void Z_AddUsage(int tag, int size)
+{
+  if (tag < PU_NUMTAGS)
+    {
+      mem_usage[tag] += size;
+      if (mem_usage[tag] > mem_peak[tag])
+	mem_peak[tag] = mem_usage[tag];
+    }
+}
+
+
 int Z_GetTag(void *ptr)
 {
   if (!ptr)
@@ -70,19 +101,161 @@ int Z_GetTag(void *ptr)
 }
 
 
-void *Z_Malloc(int size, int tag, void **user)
+int Z_GetSize(void *ptr)
 {
-  mem_extra_t *p = static_cast<mem_extra_t*>(malloc(sizeof(mem_extra_t) + size));
-  p->size = size;
-  p->tag = tag;
-  p->user = user;
+  if (!ptr)
+    {
+      I_Error("Z_GetSize: NULL given!\n");
+      return -1;
+    }
 
-  if (tag < PU_NUMTAGS)
-    mem_usage[tag] += size;
+  mem_extra_t *p = reinterpret_cast<mem_extra_t*>(static_cast<byte*>(ptr) - sizeof(mem_extra_t));
+  return p->size;
+}
+
+
+//=========================================================================
+//  Allocation profiler
+//=========================================================================
+
+/// Allocation sizes are binned in powers of four, starting from 16 bytes.
+#define MEMPROF_BUCKETS 10
+#define MEMPROF_MAXSITES 4096 ///< must fit in mem_extra_t::site
+#define MEMPROF_HASHSIZE 8192 ///< power of two, larger than MEMPROF_MAXSITES
+
+/// \brief Allocation statistics for a single Z_Malloc call site.
+struct memsite_t
+{
+  const char *file;
+  int      line;
+  int      tag;    ///< tag used in the latest allocation
+  unsigned allocs, frees;
+  double   total;  ///< bytes allocated, in total
+  int      live;   ///< bytes currently allocated
+  int      peak;   ///< high-water mark of live
+  unsigned hist[MEMPROF_BUCKETS]; ///< allocation size histogram
+};
+
+/// \brief Allocation statistics for a memtag_t.
+struct memtagstat_t
+{
+  unsigned allocs, frees;
+  double   total;
+};
+
+static bool     memprof_on = false;
+static int      memprof_numsites = 2; ///< site 0 means "not profiled", site 1 collects the allocations that do not fit in the table
+static memsite_t    memprof_sites[MEMPROF_MAXSITES];
+static Uint16       memprof_hash[MEMPROF_HASHSIZE];
+static memtagstat_t memprof_tags[PU_NUMTAGS];
+
+static const char *memtag_names[PU_NUMTAGS] =
+{
+  "static", "sound", "music", "dave", "sprite", "model", "texture", "level", "levspec", "opengl"
+};
+
+
+/// Finds or creates the site record for a call site.
+static Uint16 MemProf_Site(const char *file, int line)
+{
+  // __FILE__ strings are not merged across translation units, but the pointer is still a good key.
+  unsigned h = (unsigned(reinterpret_cast<size_t>(file)) >> 2) * 2654435761u + unsigned(line) * 40503u;
+
+  for (unsigned i = 0; i < MEMPROF_HASHSIZE; i++)
+    {
+      unsigned slot = (h + i) & (MEMPROF_HASHSIZE - 1);
+      Uint16 s = memprof_hash[slot];
+      if (!s)
+	{
+	  // new site
+	  if (memprof_numsites == MEMPROF_MAXSITES)
+	    return 1;
+
+	  s = memprof_numsites++;
+	  memprof_hash[slot] = s;
+	  memsite_t *m = &memprof_sites[s];
+	  memset(m, 0, sizeof(memsite_t));
+	  m->file = file;
+	  m->line = line;
+	  return s;
+	}
+
+      if (memprof_sites[s].file == file && memprof_sites[s].line == line)
+	return s;
+    }
+
+  return 1;
+}
+
+
+static void MemProf_Alloc(mem_extra_t *p, const char *file, int line)
+{
+  Uint16 s = MemProf_Site(file, line);
+  p->site = s;
+
+  memsite_t *m = &memprof_sites[s];
+  m->tag = p->tag;
+  m->allocs++;
+  m->total += p->size;
+  m->live += p->size;
+  if (m->live > m->peak)
+    m->peak = m->live;
+
+  int b = 0;
+  for (unsigned size = 16; b < MEMPROF_BUCKETS-1 && unsigned(p->size) > size; size <<= 2)
+    b++;
+  m->hist[b]++;
+
+  if (p->tag < PU_NUMTAGS)
+    {
+      memprof_tags[p->tag].allocs++;
+      memprof_tags[p->tag].total += p->size;
+    }
+}
+
+
+static void MemProf_Free(mem_extra_t *p)
+{
+  memsite_t *m = &memprof_sites[p->site];
+  m->frees++;
+  m->live -= p->size;
+  p->site = 0;
+
+  if (p->tag < PU_NUMTAGS)
+    memprof_tags[p->tag].frees++;
+}
+
+
+
+void *Z_Malloc2(int size, int tag, void **user, const char *file, int line)
+{
+  byte *ret;
+  mem_extra_t *p;
+
+  if (bound_region && (tag == PU_LEVEL || tag == PU_LEVSPEC))
+    {
+      ret = static_cast<byte*>(bound_region->Malloc(size, tag, user));
+      p = reinterpret_cast<mem_extra_t*>(ret - sizeof(mem_extra_t));
+    }
+  else
+    {
+      p = static_cast<mem_extra_t*>(malloc(sizeof(mem_extra_t) + size));
+      p->size = size;
+      p->site = 0;
+      p->tag = tag;
+      p->region = 0;
+      p->user = user;
+
+      Z_AddUsage(tag, size);
+
+      ret = reinterpret_cast<byte*>(p) + sizeof(mem_extra_t);
+      if (user)
+	*user = ret;
+    }
+
+  if (memprof_on)
+    MemProf_Alloc(p, file, line);
 
-  byte *ret = reinterpret_cast<byte*>(p) + sizeof(mem_extra_t);
-  if (user)
-    *user = ret;
   return ret;
 }
 
@@ -97,6 +270,16 @@ void Z_Free(void *ptr)
 
   mem_extra_t *p = reinterpret_cast<mem_extra_t*>(static_cast<byte*>(ptr) - sizeof(mem_extra_t));
 
+  if (p->site)
+    MemProf_Free(p);
+
+  if (p->region)
+    {
+      // the memory itself is reclaimed when the region goes
+      regions[p->region - 1]->Free(p);
+      return;
+    }
+
   if (p->tag < PU_NUMTAGS)
     mem_usage[p->tag] -= p->size;
 
@@ -112,19 +295,280 @@ char *Z_Strdup(const char *s, int tag, void **user)
 }
 
 
+
+//=========================================================================
+//  Memory regions
+//=========================================================================
+
+// all blocks and chunk headers are aligned to this
+#define REGION_ALIGN(x) (((x) + 15) & ~15)
+
+memregion_t::memregion_t(unsigned cs)
+{
+  for (index = 0; index < MAX_REGIONS && regions[index]; index++)
+    ;
+  if (index == MAX_REGIONS)
+    I_Error("memregion_t: Too many memory regions!\n");
+
+  regions[index] = this;
+
+  chunksize = cs;
+  chunks = NULL;
+  owned = NULL;
+  for (int i=0; i<PU_NUMTAGS; i++)
+    usage[i] = 0;
+}
+
+
+memregion_t::~memregion_t()
+{
+  if (bound_region == this)
+    bound_region = NULL;
+
+  // clear the owners of the blocks that were never freed
+  for (owned_t *o = owned; o; o = o->next)
+    {
+      if (o->block->user)
+	*o->block->user = NULL;
+
+      if (o->block->site)
+	MemProf_Free(o->block);
+    }
+
+  for (int i=0; i<PU_NUMTAGS; i++)
+    mem_usage[i] -= usage[i];
+
+  // and give back the memory, one chunk at a time
+  chunk_t *next;
+  for (chunk_t *c = chunks; c; c = next)
+    {
+      next = c->next;
+      free(c);
+    }
+
+  regions[index] = NULL;
+}
+
+
+// Grabs size bytes from the chunks, allocating a new chunk if needed.
+void *memregion_t::Bump(unsigned size)
+{
+  const unsigned header = REGION_ALIGN(sizeof(chunk_t));
+  size = REGION_ALIGN(size);
+
+  if (!chunks || chunks->size - chunks->used < size)
+    {
+      // large blocks get a chunk of their own
+      bool single = (size > chunksize/4);
+      unsigned csize = single ? size : chunksize;
+
+      chunk_t *c = static_cast<chunk_t*>(malloc(header + csize));
+      if (!c)
+	I_Error("memregion_t: Could not allocate %d bytes.\n", header + csize);
+      c->size = csize;
+      c->used = 0;
+
+      if (single && chunks)
+	{
+	  // keep bumping the current chunk
+	  c->next = chunks->next;
+	  chunks->next = c;
+	}
+      else
+	{
+	  c->next = chunks;
+	  chunks = c;
+	}
+
+      c->used = size;
+      return reinterpret_cast<byte*>(c) + header;
+    }
+
+  byte *ret = reinterpret_cast<byte*>(chunks) + header + chunks->used;
+  chunks->used += size;
+  return ret;
+}
+
+
+void *memregion_t::Malloc(int size, int tag, void **user)
+{
+  mem_extra_t *p = static_cast<mem_extra_t*>(Bump(sizeof(mem_extra_t) + size));
+  p->size = size;
+  p->site = 0;
+  p->tag = tag;
+  p->region = index + 1;
+  p->user = user;
+
+  usage[tag] += size;
+  Z_AddUsage(tag, size);
+
+  byte *ret = reinterpret_cast<byte*>(p) + sizeof(mem_extra_t);
+  if (user || memprof_on)
+    {
+      // remember the block so that the owner (and the profiler) can be notified when the region goes
+      owned_t *o = static_cast<owned_t*>(Bump(sizeof(owned_t)));
+      o->block = p;
+      o->next = owned;
+      owned = o;
+
+      if (user)
+	*user = ret;
+    }
+  return ret;
+}
+
+
+void memregion_t::Free(mem_extra_t *p)
+{
+  usage[p->tag] -= p->size;
+  mem_usage[p->tag] -= p->size;
+
+  if (p->user)
+    {
+      *p->user = NULL;
+      p->user = NULL;
+    }
+}
+
+
+unsigned memregion_t::Reserved() const
+{
+  unsigned total = 0;
+  for (chunk_t *c = chunks; c; c = c->next)
+    total += REGION_ALIGN(sizeof(chunk_t)) + c->size;
+  return total;
+}
+
+
+memregion_t *Z_SetRegion(memregion_t *r)
+{
+  memregion_t *old = bound_region;
+  bound_region = r;
+  return old;
+}
+
+
+
+//=========================================================================
+//  Slab pools
+//=========================================================================
+
+static mempool_t *pools = NULL; ///< all the existing pools
+
+mempool_t::mempool_t(const char *n, int t)
+{
+  name = n;
+  tag = t;
+  for (int i=0; i < POOL_MAXSIZE / POOL_GRANULARITY; i++)
+    {
+      classes[i].freelist = NULL;
+      classes[i].slabs = classes[i].used = 0;
+    }
+  large = 0;
+
+  next = pools;
+  pools = this;
+}
+
+
+void *mempool_t::Alloc(size_t size)
+{
+  if (!biglock_t::Serialized())
+    I_Error("mempool_t: %s allocation by a job not holding a lock.\n", name);
+
+  if (size > POOL_MAXSIZE)
+    {
+      large += size;
+      Z_AddUsage(tag, size);
+      return malloc(size);
+    }
+
+  int c = (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY - 1;
+  sizeclass_t &sc = classes[c];
+
+  if (!sc.freelist)
+    {
+      // carve a new slab into slots
+      unsigned slotsize = (c + 1) * POOL_GRANULARITY;
+      byte *slab = static_cast<byte*>(malloc(POOL_SLABSIZE));
+      if (!slab)
+	I_Error("mempool_t: Could not allocate a new slab.\n");
+
+      for (int i = POOL_SLABSIZE / slotsize - 1; i >= 0; i--)
+	{
+	  slot_t *s = reinterpret_cast<slot_t*>(slab + i * slotsize);
+	  s->next = sc.freelist;
+	  sc.freelist = s;
+	}
+      sc.slabs++;
+      Z_AddUsage(tag, POOL_SLABSIZE);
+    }
+
+  slot_t *s = sc.freelist;
+  sc.freelist = s->next;
+  sc.used++;
+  return s;
+}
+
+
+void mempool_t::Free(void *p, size_t size)
+{
+  if (!biglock_t::Serialized())
+    I_Error("mempool_t: %s freed by a job not holding a lock.\n", name);
+
+  if (size > POOL_MAXSIZE)
+    {
+      large -= size;
+      Z_AddUsage(tag, -int(size));
+      free(p);
+      return;
+    }
+
+  int c = (size + POOL_GRANULARITY - 1) / POOL_GRANULARITY - 1;
+  sizeclass_t &sc = classes[c];
+
+  slot_t *s = static_cast<slot_t*>(p);
+  s->next = sc.freelist;
+  sc.freelist = s;
+  sc.used--;
+}
+
+
+void mempool_t::Print() const
+{
+  unsigned slabs = 0, used = 0;
+  for (int i=0; i < POOL_MAXSIZE / POOL_GRANULARITY; i++)
+    {
+      slabs += classes[i].slabs;
+      used += classes[i].slabs ? classes[i].used * (i + 1) * POOL_GRANULARITY : 0;
+    }
+
+  CONS_Printf("%-12s  %6d kB in %4d slabs, %6d kB used, %6d kB large objects\n",
+	      name, (slabs * POOL_SLABSIZE) >> 10, slabs, used >> 10, large >> 10);
+}
+
+
+void mempool_t::PrintAll()
+{
+  for (mempool_t *p = pools; p; p = p->next)
+    p->Print();
+}
+
+
+
 void Command_Meminfo_f()
 {
   CONS_Printf("\2Memory Info\n");
-
-  CONS_Printf("Unspecified:  %8d kB\n", Z_TagUsage(PU_STATIC) >> 10);
-  CONS_Printf("Sounds:       %8d kB\n", Z_TagUsage(PU_SOUND) >> 10);
-  CONS_Printf("Music:        %8d kB\n", Z_TagUsage(PU_MUSIC) >> 10);
-  CONS_Printf("Textures:     %8d kB\n", Z_TagUsage(PU_TEXTURE) >> 10);
-  CONS_Printf("Sprites:      %8d kB\n", Z_TagUsage(PU_SPRITE) >> 10);
-  CONS_Printf("3D models:    %8d kB\n", Z_TagUsage(PU_MODEL) >> 10);
-  CONS_Printf("\nMap data:     %8d kB\n", Z_TagUsage(PU_LEVEL) >> 10);
-  CONS_Printf("Thinkers:     %8d kB\n", Z_TagUsage(PU_LEVSPEC) >> 10);
-  CONS_Printf("Dave demands: %8d kB\n", Z_TagUsage(PU_DAVE) >> 10);
+  CONS_Printf("                  current        peak\n");
+  CONS_Printf("Unspecified:  %8d kB %8d kB\n", Z_TagUsage(PU_STATIC) >> 10, Z_TagPeak(PU_STATIC) >> 10);
+  CONS_Printf("Sounds:       %8d kB %8d kB\n", Z_TagUsage(PU_SOUND) >> 10, Z_TagPeak(PU_SOUND) >> 10);
+  CONS_Printf("Music:        %8d kB %8d kB\n", Z_TagUsage(PU_MUSIC) >> 10, Z_TagPeak(PU_MUSIC) >> 10);
+  CONS_Printf("Textures:     %8d kB %8d kB\n", Z_TagUsage(PU_TEXTURE) >> 10, Z_TagPeak(PU_TEXTURE) >> 10);
+  CONS_Printf("Sprites:      %8d kB %8d kB\n", Z_TagUsage(PU_SPRITE) >> 10, Z_TagPeak(PU_SPRITE) >> 10);
+  CONS_Printf("3D models:    %8d kB %8d kB\n", Z_TagUsage(PU_MODEL) >> 10, Z_TagPeak(PU_MODEL) >> 10);
+  CONS_Printf("\nMap data:     %8d kB %8d kB\n", Z_TagUsage(PU_LEVEL) >> 10, Z_TagPeak(PU_LEVEL) >> 10);
+  CONS_Printf("Thinkers:     %8d kB %8d kB\n", Z_TagUsage(PU_LEVSPEC) >> 10, Z_TagPeak(PU_LEVSPEC) >> 10);
+  CONS_Printf("Dave demands: %8d kB %8d kB\n", Z_TagUsage(PU_DAVE) >> 10, Z_TagPeak(PU_DAVE) >> 10);
   //CONS_Printf("OpenGL stuff: %8d kB\n", Z_TagUsage(PU_OPENGL_GEOMETRY) >> 10);
 
   int total = 0;
@@ -132,6 +576,17 @@ void Command_Meminfo_f()
     total += mem_usage[i];
   CONS_Printf("\nTotal:        %8d kB\n", total >> 10);
 
+  int nregions = 0;
+  unsigned reserved = 0;
+  for (int i=0; i<MAX_REGIONS; i++)
+    if (regions[i])
+      {
+	nregions++;
+	reserved += regions[i]->Reserved();
+      }
+  CONS_Printf("%d memory regions, %d kB reserved\n", nregions, reserved >> 10);
+  mempool_t::PrintAll();
+
   CONS_Printf("\2\nSystem Memory Info\n");
   Uint32 freebytes, totalbytes;
   freebytes = I_GetFreeMem(&totalbytes);
@@ -141,6 +596,156 @@ void Command_Meminfo_f()
 
 
 
+/// strips the directories from a __FILE__ string
+static const char *MemProf_Basename(const char *file)
+{
+  const char *p = strrchr(file, '/');
+  const char *q = strrchr(file, '\\');
+  if (q > p)
+    p = q;
+  return p ? p+1 : file;
+}
+
+
+static bool MemProf_LiveOrder(const memsite_t *a, const memsite_t *b)
+{
+  return a->live > b->live;
+}
+
+
+static void MemProf_Reset()
+{
+  for (int i=1; i<memprof_numsites; i++)
+    {
+      // live must stay intact, those blocks will be freed later
+      memsite_t *m = &memprof_sites[i];
+      m->allocs = m->frees = 0;
+      m->total = 0;
+      m->peak = m->live;
+      memset(m->hist, 0, sizeof(m->hist));
+    }
+
+  for (int i=0; i<PU_NUMTAGS; i++)
+    {
+      memprof_tags[i].allocs = memprof_tags[i].frees = 0;
+      memprof_tags[i].total = 0;
+      mem_peak[i] = mem_usage[i];
+    }
+}
+
+
+static void MemProf_Dump(int n)
+{
+  CONS_Printf("\2Allocations by tag\n");
+  CONS_Printf("tag        allocs    frees    total kB     live kB     peak kB\n");
+  for (int i=0; i<PU_NUMTAGS; i++)
+    CONS_Printf("%-8s %8d %8d %11.0f %11d %11d\n", memtag_names[i], memprof_tags[i].allocs, memprof_tags[i].frees,
+		memprof_tags[i].total / 1024, mem_usage[i] >> 10, mem_peak[i] >> 10);
+
+  vector<memsite_t*> order;
+  for (int i=1; i<memprof_numsites; i++)
+    if (memprof_sites[i].allocs || memprof_sites[i].live)
+      order.push_back(&memprof_sites[i]);
+  sort(order.begin(), order.end(), MemProf_LiveOrder);
+
+  if (n > int(order.size()))
+    n = order.size();
+
+  CONS_Printf("\2\nTop %d of %d call sites by live memory\n", n, order.size());
+  CONS_Printf("   live kB   peak kB   allocs    frees tag      site\n");
+  for (int i=0; i<n; i++)
+    {
+      memsite_t *m = order[i];
+      CONS_Printf("%10d %9d %8d %8d %-8s %s:%d\n", m->live >> 10, m->peak >> 10, m->allocs, m->frees,
+		  memtag_names[m->tag < PU_NUMTAGS ? m->tag : 0], MemProf_Basename(m->file), m->line);
+    }
+}
+
+
+static void MemProf_WriteCSV(const char *filename)
+{
+  FILE *f = fopen(filename, "w");
+  if (!f)
+    {
+      CONS_Printf("Could not open '%s' for writing.\n", filename);
+      return;
+    }
+
+  fprintf(f, "kind,file,line,tag,allocs,frees,total_bytes,live_bytes,peak_bytes");
+  for (int b=0, size=16; b<MEMPROF_BUCKETS; b++, size <<= 2)
+    {
+      if (b < MEMPROF_BUCKETS-1)
+	fprintf(f, ",le_%d", size);
+      else
+	fprintf(f, ",gt_%d", size >> 2);
+    }
+  fprintf(f, "\n");
+
+  for (int i=0; i<PU_NUMTAGS; i++)
+    {
+      fprintf(f, "tag,,,%s,%u,%u,%.0f,%u,%u", memtag_names[i], memprof_tags[i].allocs, memprof_tags[i].frees,
+	      memprof_tags[i].total, mem_usage[i], mem_peak[i]);
+      for (int b=0; b<MEMPROF_BUCKETS; b++)
+	fprintf(f, ",");
+      fprintf(f, "\n");
+    }
+
+  int n = 0;
+  for (int i=1; i<memprof_numsites; i++)
+    {
+      memsite_t *m = &memprof_sites[i];
+      if (!m->file)
+	continue; // the profiler was never on
+
+      n++;
+      fprintf(f, "site,%s,%d,%s,%u,%u,%.0f,%d,%d", m->file, m->line, memtag_names[m->tag < PU_NUMTAGS ? m->tag : 0],
+	      m->allocs, m->frees, m->total, m->live, m->peak);
+      for (int b=0; b<MEMPROF_BUCKETS; b++)
+	fprintf(f, ",%u", m->hist[b]);
+      fprintf(f, "\n");
+    }
+
+  fclose(f);
+  CONS_Printf("Wrote %d call sites to '%s'.\n", n, filename);
+}
+
+
+/// Allocation profiler. Records the allocations made by Z_Malloc per tag and per call site.
+void Command_MemProf_f()
+{
+  const char *usage = "memprof on | off | reset | dump [n] | csv <file>\n";
+
+  if (COM.Argc() < 2)
+    {
+      CONS_Printf(usage);
+      CONS_Printf("The allocation profiler is %s, %d call sites seen.\n", memprof_on ? "on" : "off", memprof_numsites-2);
+      return;
+    }
+
+  const char *cmd = COM.Argv(1);
+  if (!strcasecmp(cmd, "on"))
+    {
+      memprof_sites[1].file = "(other sites)";
+      memprof_on = true;
+      CONS_Printf("Allocation profiler on.\n");
+    }
+  else if (!strcasecmp(cmd, "off"))
+    {
+      memprof_on = false; // blocks allocated while profiling are still tracked when freed
+      CONS_Printf("Allocation profiler off.\n");
+    }
+  else if (!strcasecmp(cmd, "reset"))
+    MemProf_Reset();
+  else if (!strcasecmp(cmd, "dump"))
+    MemProf_Dump(COM.Argc() > 2 ? atoi(COM.Argv(2)) : 20);
+  else if (!strcasecmp(cmd, "csv") && COM.Argc() > 2)
+    MemProf_WriteCSV(COM.Argv(2));
+  else
+    CONS_Printf(usage);
+}
+
+
+
 #if 0 // the rest is obsolete
 
 
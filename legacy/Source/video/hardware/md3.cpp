@@ -104,6 +104,8 @@ MD3_player *modelcache_t::Load(const char *p)
 TGATexture::TGATexture(const char *n, int l)
   : LumpTexture(n, l, 0, 0)
 {
+  data = NULL;
+
   // Loads 24 and 32bpp (alpha channel) TGA textures
   // TGA format is little-endian (LSB)
   struct TGAheader
@@ -167,6 +169,23 @@ TGATexture::~TGATexture()
 }
 
 
+unsigned TGATexture::Size()
+{
+  unsigned size = data ? Z_GetSize(data) : 0;
+  if (gl_id != NOTEXTURE)
+    size += width * height * (bpp / 8);
+  return size;
+}
+
+
+/// pixels points inside data, so only the OpenGL texture is flushed.
+bool TGATexture::Flush()
+{
+  ClearGLTexture();
+  return true;
+}
+
+
 void TGATexture::GLGetData()
 {
   if (!pixels)
@@ -211,6 +230,12 @@ MD3_t::~MD3_t()
     Z_Free(meshes);
 }
 
+
+unsigned MD3_t::Size() const
+{
+  return (data ? Z_GetSize(data) : 0) + (meshes ? Z_GetSize(meshes) : 0);
+}
+
 // given a *.md3 file name, loads the model to memory
 bool MD3_t::Load(const string& filename)
 {
@@ -505,6 +530,12 @@ MD3_player::MD3_player(const char *n)
 MD3_player::~MD3_player() {}
 
 
+unsigned MD3_player::Size()
+{
+  return legs.Size() + torso.Size() + head.Size();
+}
+
+
 // loads a player model to memory
 // path should end in a slash
 bool MD3_player::Load(const string& path, const string& skin)
@@ -55,8 +55,6 @@
 #include "z_zone.h"
 
 
-extern trace_t trace;
-
 void MD3_InitNormLookup();
 
 
@@ -738,7 +736,7 @@ void OGLRenderer::DrawAutomapLine(const fline_t *line, const int color)
 
 void OGLRenderer::RenderPlayerView(PlayerInfo *player)
 {
-  validcount++;
+  NewValidCount();
 
   // Set up the Map to be rendered. Needs to be done separately for each viewport, since the engine
   // can run several Maps at once.
@@ -765,7 +763,7 @@ void OGLRenderer::RenderPlayerView(PlayerInfo *player)
       glPopMatrix();
 
       glClear(GL_DEPTH_BUFFER_BIT);
-      validcount++; // prepare to render same sectors again if necessary
+      NewValidCount(); // prepare to render same sectors again if necessary
     }
 
   // render main view
@@ -783,9 +781,10 @@ void OGLRenderer::RenderPlayerView(PlayerInfo *player)
       } else {
 	aimsine = Sin(player->pawn->pitch).Float();
       }
-      player->pawn->LineTrace(player->pawn->yaw, 30000, aimsine, false);
+      query_scope_t q(player->pawn->mp);
+      player->pawn->LineTrace(*q, player->pawn->yaw, 30000, aimsine, false);
 
-      vec_t<fixed_t> target = trace.Point(trace.frac);
+      vec_t<fixed_t> target = q->trace.Point(q->trace.frac);
 
       //if (!(player->mp->maptic & 0xF))
       //  CONS_Printf("targ: %f, %f, %f, dist %f\n", target.x.Float(), target.y.Float(), target.z.Float(), trace.frac);
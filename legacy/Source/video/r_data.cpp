@@ -293,6 +293,30 @@ Texture::~Texture()
 }
 
 
+/// Payload: the bitmap and the OpenGL texture (approximately, mipmaps excluded).
+unsigned Texture::Size()
+{
+  unsigned size = pixels ? Z_GetSize(pixels) : 0;
+  if (gl_id != NOTEXTURE)
+    size += width * height * sizeof(RGBA_t);
+  return size;
+}
+
+
+/// Both the bitmap and the OpenGL texture are regenerated on demand.
+bool Texture::Flush()
+{
+  ClearGLTexture();
+
+  if (pixels)
+    {
+      Z_Free(pixels);
+      pixels = NULL; // GLGetData may have allocated it without an owner
+    }
+  return true;
+}
+
+
 // This basic version of the virtual method is used for native indexed col-major formats.
 void Texture::GLGetData()
 {
@@ -332,6 +356,8 @@ void Texture::GLGetData()
 /// Uses the virtualized GLGetData().
 GLuint Texture::GLPrepare()
 {
+  Touch();
+
   if (gl_id == NOTEXTURE)
     {
       GLGetData();
@@ -476,11 +502,11 @@ byte *LumpTexture::GetData()
 //==================================================================
 
 // Clip and draw a column from a patch into a cached post.
-static void R_DrawColumnInCache(column_t *col, byte *cache, int originy, int cacheheight)
+static void R_DrawColumnInCache(const column_t *col, byte *cache, int originy, int cacheheight)
 {
   while (col->topdelta != 0xff)
     {
-      byte *source = col->data; // go to the data
+      const byte *source = col->data; // go to the data
       int count = col->length;
       int position = originy + col->topdelta;
 
@@ -497,7 +523,7 @@ static void R_DrawColumnInCache(column_t *col, byte *cache, int originy, int cac
       if (count > 0)
         memcpy(cache + position, source, count);
 
-      col = reinterpret_cast<column_t*>(&col->data[col->length + 1]);
+      col = reinterpret_cast<const column_t*>(&col->data[col->length + 1]);
     }
 }
 
@@ -529,6 +555,21 @@ PatchTexture::~PatchTexture()
 }
 
 
+unsigned PatchTexture::Size()
+{
+  return Texture::Size() + (patch_data ? Z_GetSize(patch_data) : 0);
+}
+
+
+bool PatchTexture::Flush()
+{
+  if (patch_data)
+    Z_Free(patch_data); // owner is patch_data
+
+  return Texture::Flush();
+}
+
+
 /// sets patch_data
 patch_t *PatchTexture::GeneratePatch()
 {
@@ -624,6 +665,22 @@ DoomTexture::~DoomTexture()
 }
 
 
+unsigned DoomTexture::Size()
+{
+  return Texture::Size() + (patch_data ? Z_GetSize(patch_data) : 0);
+}
+
+
+/// columnofs lives inside pixels and is rebuilt along with it.
+bool DoomTexture::Flush()
+{
+  if (patch_data)
+    Z_Free(patch_data); // owner is patch_data
+
+  return Texture::Flush();
+}
+
+
 
 // TODO better DoomTexture handling?
 // When a texture is first needed,
@@ -711,7 +768,8 @@ byte *DoomTexture::GetData()
       // Composite the patches together.
       for (i=0, tp = patches; i<patchcount; i++, tp++)
         {
-	  patch_t *p = static_cast<patch_t*>(fc.CacheLumpNum(tp->patchlump, PU_STATIC));
+	  // read-only, so the patch can be used straight from a memory mapped wad
+	  const patch_t *p = static_cast<const patch_t*>(fc.AcquireLump(tp->patchlump));
           int x1 = tp->originx;
           int x2 = x1 + SHORT(p->width);
 
@@ -724,11 +782,11 @@ byte *DoomTexture::GetData()
 
           for ( ; x < x2; x++)
             {
-              column_t *patchcol = reinterpret_cast<column_t*>(reinterpret_cast<byte*>(p) + LONG(p->columnofs[x-x1]));
+              const column_t *patchcol = reinterpret_cast<const column_t*>(reinterpret_cast<const byte*>(p) + LONG(p->columnofs[x-x1]));
               R_DrawColumnInCache(patchcol, pixels + columnofs[x], tp->originy, height);
             }
 
-	  Z_Free(p);
+	  fc.ReleaseLump(tp->patchlump, p);
         }
 
       // TODO do a palette conversion if needed
@@ -1872,7 +1930,8 @@ fadetable_t *R_CreateColormap(char *p1, char *p2, char *p3)
       deltas[i][2] = (cmap[i][2] - cdestb) / (double)fadedist;
     }
 
-    char *colormap_p = static_cast<char*>(Z_MallocAlign((256 * 34) + 1, PU_LEVEL, 0, 8));
+    // fadetables are shared by all maps
+    char *colormap_p = static_cast<char*>(Z_MallocAlign((256 * 34) + 1, PU_STATIC, 0, 8));
     f->colormap = reinterpret_cast<lighttable_t*>(colormap_p);
 
     for(p = 0; p < 34; p++)
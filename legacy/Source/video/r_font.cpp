@@ -467,6 +467,10 @@ public:
     pixels = NULL;
   }
 
+  /// pixels belongs to the SDL_Surface, only the OpenGL texture can be flushed
+  virtual unsigned Size() { return gl_id != NOTEXTURE ? width * height * 4 : 0; }
+  virtual bool Flush() { ClearGLTexture(); return true; }
+
   virtual byte *GetData() { return pixels; }
   /*
   {
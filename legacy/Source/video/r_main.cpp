@@ -21,6 +21,7 @@
 /// \file
 /// \brief Rendering main loop and setup, utility functions (BSP, geometry, trigonometry).
 
+#include <atomic>
 #include "doomdef.h"
 
 #include "command.h"
@@ -47,6 +48,7 @@
 #include "i_video.h"
 #include "v_video.h"
 
+#include "m_profile.h"
 #include "w_wad.h"
 
 
@@ -65,8 +67,16 @@ angle_t G_ClipAimingPitch(angle_t pitch);
 
 int                     viewangleoffset = 0; // obsolete, for multiscreen setup...
 
-// increment every time a check is made
-int                     validcount = 1;
+// set to a new value every time a check is made
+thread_local int        validcount = 1;
+
+/// Source of validcount values. Shared by all threads, so marks left by one thread never match the checks of another.
+static std::atomic<int> validcount_source(1);
+
+int NewValidCount()
+{
+  return validcount = ++validcount_source;
+}
 
 
 
@@ -569,11 +579,15 @@ void R_ServerInit()
   CONS_Printf("Creating textures...\n");
   materials.Clear();
   materials.SetDefaultItem("DEF_TEX");
-  materials.ReadTextures();
+  {
+    stagetimer_t s("textures");
+    materials.ReadTextures();
+  }
   //materials.Inventory();
 
   // set the default items for sprite and model caches
   CONS_Printf("Initializing sprites and models...\n");
+  stagetimer_t s("sprites");
   R_InitSprites();
 }
 
@@ -596,7 +610,10 @@ void R_Init()
   R_SetViewSize();
 
   // load lightlevel colormaps and Boom extra colormaps
-  R_InitColormaps();
+  {
+    stagetimer_t s("colormaps");
+    R_InitColormaps();
+  }
 
   // initialize sw renderer lightlevel tables (colormaps...)
   R_InitLightTables();
@@ -605,7 +622,10 @@ void R_Init()
   R_InitTranslationTables();
 
   // load or create translucency tables
-  R_InitTranslucencyTables();
+  {
+    stagetimer_t s("translucency tables");
+    R_InitTranslucencyTables();
+  }
 
   R_InitDrawNodes();
 
@@ -684,7 +704,7 @@ void Rend::R_SetupFrame(PlayerInfo *player)
   centeryfrac = centery;
 
   framecount++;
-  validcount++;
+  NewValidCount();
 }
 
 
@@ -719,6 +739,8 @@ void R_SetViewport(int viewport)
 
 void Rend::R_RenderPlayerView(PlayerInfo *player)
 {
+  PROFILE_ZONE("R_RenderPlayerView");
+
   SetMap(player->mp);
   R_SetupFrame(player);
 
@@ -132,6 +132,7 @@ void Material::Draw(float x, float y, int scrn)
   fixed_t row = (y1 - y)*rowfrac;
 
 
+  tex[0].t->Touch();
   tex[0].t->Draw(dest_tl, dest_tr, dest_bl, col, row, colfrac, rowfrac, flags);
 }
 
@@ -213,6 +214,7 @@ void Material::DrawFill(int x, int y, int w, int h)
       return;
     }
   
+  tex[0].t->Touch();
   tex[0].t->DrawFill(x, y, w, h);
 }
 